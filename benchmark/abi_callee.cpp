@@ -0,0 +1,71 @@
+// Keep this file out of LTO, see the expected64_abi_callee target
+#include <type_traits>
+
+#include "abi_callee.hpp"
+
+namespace
+{
+template<typename T>
+bool rejected(T input)
+{
+  if constexpr (std::is_pointer_v<T>) {
+    return *input < 0;
+  } else if constexpr (std::is_unsigned_v<T>) {
+    return input > (static_cast<T>(1) << 60);  // Negative numbers cast to uint64_t
+  } else {
+    return input < 0;
+  }
+}
+
+template<typename T>
+T work(T input)
+{
+  if constexpr (std::is_pointer_v<T>) {
+    return input;
+  } else {
+    return input * 3;
+  }
+}
+}  // namespace
+
+template<typename T>
+T abi_raw(T input)
+{
+  return rejected(input) ? T {} : work(input);
+}
+
+template<typename T>
+expected64<T, abi_error> abi_expected64(T input)
+{
+  if (rejected(input))
+    return expected64<T, abi_error>(abi_error::rejected);
+  return expected64<T, abi_error>(work(input));
+}
+
+template<typename T>
+tl::expected<T, abi_error> abi_tl_expected(T input)
+{
+  if (rejected(input))
+    return tl::unexpected {abi_error::rejected};
+  return work(input);
+}
+
+template<typename T>
+std::optional<T> abi_optional(T input)
+{
+  if (rejected(input))
+    return std::nullopt;
+  return work(input);
+}
+
+#if defined(__cpp_lib_expected)
+template<typename T>
+std::expected<T, abi_error> abi_std_expected(T input)
+{
+  if (rejected(input))
+    return std::unexpected {abi_error::rejected};
+  return work(input);
+}
+#endif
+
+EXPECTED64_ABI_ALL_CALLEES(template)
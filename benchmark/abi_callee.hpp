@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#if __has_include(<expected>)
+#  include <expected>
+#endif
+
+#include <expected64/expected64.hpp>
+#include <tl/expected.hpp>
+
+/**
+ * @brief Callees for bench_abi.cpp
+ *
+ * They are compiled in their own library without LTO and marked noinline, so every call returns through the real
+ * calling convention: expected64 in rax or xmm0, the 16-byte types in two registers or through memory. Each one
+ * returns 3 * input, or input itself for pointers, and an error for negative inputs.
+ */
+
+enum class abi_error : uint8_t
+{
+  rejected = 1
+};
+
+template<typename T>
+[[gnu::noinline]] T abi_raw(T input);  // Returns T {} instead of an error
+
+template<typename T>
+[[gnu::noinline]] expected64<T, abi_error> abi_expected64(T input);
+
+template<typename T>
+[[gnu::noinline]] tl::expected<T, abi_error> abi_tl_expected(T input);
+
+template<typename T>
+[[gnu::noinline]] std::optional<T> abi_optional(T input);
+
+#if defined(__cpp_lib_expected)
+template<typename T>
+[[gnu::noinline]] std::expected<T, abi_error> abi_std_expected(T input);
+#endif
+
+// Instantiated in abi_callee.cpp only
+#define EXPECTED64_ABI_CALLEES(prefix, T) \
+  prefix T abi_raw<T>(T); \
+  prefix expected64<T, abi_error> abi_expected64<T>(T); \
+  prefix tl::expected<T, abi_error> abi_tl_expected<T>(T); \
+  prefix std::optional<T> abi_optional<T>(T);
+
+#if defined(__cpp_lib_expected)
+#  define EXPECTED64_ABI_STD_CALLEES(prefix, T) prefix std::expected<T, abi_error> abi_std_expected<T>(T);
+#else
+#  define EXPECTED64_ABI_STD_CALLEES(prefix, T)
+#endif
+
+using abi_pointer = const int64_t*;
+
+#define EXPECTED64_ABI_ALL_CALLEES(prefix) \
+  EXPECTED64_ABI_CALLEES(prefix, int64_t) \
+  EXPECTED64_ABI_CALLEES(prefix, uint64_t) \
+  EXPECTED64_ABI_CALLEES(prefix, double) \
+  EXPECTED64_ABI_CALLEES(prefix, abi_pointer) \
+  EXPECTED64_ABI_STD_CALLEES(prefix, int64_t) \
+  EXPECTED64_ABI_STD_CALLEES(prefix, uint64_t) \
+  EXPECTED64_ABI_STD_CALLEES(prefix, double) \
+  EXPECTED64_ABI_STD_CALLEES(prefix, abi_pointer)
+
+EXPECTED64_ABI_ALL_CALLEES(extern template)
@@ -1,45 +1,85 @@
 #include <algorithm>  // for std::shuffle
+#include <cstdlib>  // for std::abs
 #include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 #include "common.hpp"
+#include "perf_counters.hpp"
+
+#include <expected64/flat_map.hpp>
+#include <expected64/memo_cache.hpp>
+#include <expected64/parallel.hpp>
+
+// A Catch2 benchmark followed by the hardware counters of a separate run of the same body. Catch2 only calls the meter
+// when the benchmark runs, so skipped ones (--skip-benchmarks) report no counters either.
+template<typename F>
+void counted_benchmark(const std::string& name, F body)
+{
+  bool ran = false;
+  BENCHMARK_ADVANCED(std::string(name))(Catch::Benchmark::Chronometer meter)
+  {
+    ran = true;
+    meter.measure(body);
+  };
+  if (ran) {
+    report_perf_counters(name, body);
+  }
+}
 
 template<typename T>
 void run_factorial_benchmarks()
 {
   std::vector<int> numbers = gen_shuffled_numbers();
 
-  BENCHMARK("Factorial with expected64")
-  {
-    T score = 0;
-    for (int num : numbers) {
-      auto result = factorial_expected64<T>(num);
-      score += result.has_error() ? 0 : result.get_value();
-    }
-    return score;
-  };
+  counted_benchmark("Factorial with expected64",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = factorial_expected64<T>(num);
+                        score += result.has_error() ? 0 : result.get_value();
+                      }
+                      return score;
+                    });
 
-  BENCHMARK("Factorial with std::optional")
-  {
-    T score = 0;
-    for (int num : numbers) {
-      auto result = factorial_optional<T>(num);
-      score += result.has_value() ? result.value() : 0;
-    }
-    return score;
-  };
+  counted_benchmark("Factorial with std::optional",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = factorial_optional<T>(num);
+                        score += result.has_value() ? result.value() : 0;
+                      }
+                      return score;
+                    });
 
-  BENCHMARK("Factorial with Raw Type")
-  {
-    T score = 0;
-    for (int num : numbers) {
-      auto result = factorial<T>(num);
-      score += (result > 0) ? result : 0;
-    }
-    return score;
-  };
+  counted_benchmark("Factorial with optional64",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = factorial_optional64<T>(num);
+                        score += result.has_value() ? *result : 0;
+                      }
+                      return score;
+                    });
+
+  counted_benchmark("Factorial with Raw Type",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = factorial<T>(num);
+                        score += (result > 0) ? result : 0;
+                      }
+                      return score;
+                    });
 }
 
 TEST_CASE("factorial - int64_t")
@@ -62,48 +102,258 @@ void run_cube_benchmarks()
 {
   std::vector<int> numbers = gen_shuffled_numbers();
 
-  BENCHMARK("Cube with expected64")
+  counted_benchmark("Cube with expected64",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = cube_expected64<T>(static_cast<T>(num));
+                        score += result.has_error() ? 0 : result.get_value();
+                      }
+                      return score;
+                    });
+
+  counted_benchmark("Cube with std::optional",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = cube_optional<T>(static_cast<T>(num));
+                        score += result.has_value() ? result.value() : 0;
+                      }
+                      return score;
+                    });
+
+  counted_benchmark("Cube with Raw Type",
+                    [&]
+                    {
+                      T score = 0;
+                      for (int num : numbers) {
+                        auto result = cube<T>(static_cast<T>(num));
+                        score += result;
+                      }
+                      return score;
+                    });
+}
+
+TEST_CASE("cube - int64_t")
+{
+  run_cube_benchmarks<int64_t>();
+}
+
+TEST_CASE("cube - uint64_t")
+{
+  run_cube_benchmarks<uint64_t>();
+}
+
+TEST_CASE("cube - double")
+{
+  run_cube_benchmarks<double>();
+}
+
+// Branchy and branchless checking per error rate and pattern, the crossover moves with how predictable the errors are
+template<typename T>
+void run_error_rate_benchmarks()
+{
+  for (double rate : error_rates) {
+    for (error_pattern pattern : error_patterns) {
+      if (rate <= 0.0 && pattern != error_pattern::uniform) {
+        continue;  // Without errors the patterns are the same input
+      }
+      const std::vector<int> numbers = gen_numbers_with_errors(1 << 12, rate, pattern);
+      const std::string      suffix = " [" + error_config_name(rate, pattern) + "]";
+
+      counted_benchmark("Raw Type" + suffix,
+                        [&]
+                        {
+                          T score = 0;
+                          for (int num : numbers) {
+                            score += cube<T>(static_cast<T>(num));
+                          }
+                          return score;
+                        });
+
+      counted_benchmark("expected64, branchy" + suffix,
+                        [&]
+                        {
+                          T score = 0;
+                          for (int num : numbers) {
+                            auto result = cube_expected64<T>(static_cast<T>(num));
+                            score += result.has_error() ? 0 : result.get_value();
+                          }
+                          return score;
+                        });
+
+      counted_benchmark("expected64, branchless" + suffix,
+                        [&]
+                        {
+                          T score = 0;
+                          for (int num : numbers) {
+                            score += value_or_zero_branchless<T>(cube_expected64_branchless<T>(static_cast<T>(num)));
+                          }
+                          return score;
+                        });
+
+      counted_benchmark("std::optional" + suffix,
+                        [&]
+                        {
+                          T score = 0;
+                          for (int num : numbers) {
+                            auto result = cube_optional<T>(static_cast<T>(num));
+                            score += result.has_value() ? result.value() : 0;
+                          }
+                          return score;
+                        });
+    }
+  }
+}
+
+// uint64_t is left out, negative inputs wrap around instead of failing
+TEST_CASE("error rate - int64_t")
+{
+  run_error_rate_benchmarks<int64_t>();
+}
+
+TEST_CASE("error rate - double")
+{
+  run_error_rate_benchmarks<double>();
+}
+
+template<typename T>
+void run_parallel_transform_benchmarks()
+{
+  std::vector<int> numbers = gen_large_shuffled_numbers(1 << 20);
+  std::vector<expected64<T, error_code>> results(numbers.size(), expected64<T, error_code>(error_code::error));
+  const unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+  for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+    work_stealing_executor executor(threads);
+    const std::string      suffix = ", " + std::to_string(threads) + " threads";
+
+    BENCHMARK("Parallel factorial with expected64" + suffix)
+    {
+      return parallel_transform(executor, numbers, results, factorial_expected64<T>);
+    };
+
+    BENCHMARK("Parallel cube with expected64" + suffix)
+    {
+      return parallel_transform(executor, numbers, results, cube_expected64<T>);
+    };
+
+    BENCHMARK("Parallel cube with expected64, stop on first error" + suffix)
+    {
+      return parallel_transform(executor, numbers, results, cube_expected64<T>, error_policy::stop_on_first_error);
+    };
+
+    BENCHMARK("Parallel reduce of cube with expected64" + suffix)
+    {
+      return parallel_reduce(
+          executor, numbers, T {0}, cube_expected64<T>, [](T a, T b) { return a + b; }, error_policy::run_all);
+    };
+
+    if (threads == max_threads) {
+      break;
+    }
+  }
+}
+
+TEST_CASE("parallel scaling - int64_t")
+{
+  run_parallel_transform_benchmarks<int64_t>();
+}
+
+TEST_CASE("parallel scaling - double")
+{
+  run_parallel_transform_benchmarks<double>();
+}
+
+template<typename T>
+void run_memo_cache_benchmarks()
+{
+  // Map the inputs onto [0, 20] so a cache hit saves up to 20 multiplies. 20! is the largest factorial below 2^62,
+  // anything larger overflows int64_t or lands in its error niche.
+  std::vector<int> numbers = gen_large_shuffled_numbers(1 << 14);
+  for (int& num : numbers) {
+    num = std::abs(num) * 2;
+  }
+  memo_cache<int, expected64<T, error_code>> cache(1024);
+
+  BENCHMARK("Factorial with expected64, recomputed")
   {
     T score = 0;
     for (int num : numbers) {
-      auto result = cube_expected64<T>(static_cast<T>(num));
+      auto result = factorial_expected64<T>(num);
       score += result.has_error() ? 0 : result.get_value();
     }
     return score;
   };
 
-  BENCHMARK("Cube with std::optional")
+  BENCHMARK("Factorial with expected64, memoized")
   {
     T score = 0;
     for (int num : numbers) {
-      auto result = cube_optional<T>(static_cast<T>(num));
-      score += result.has_value() ? result.value() : 0;
+      auto result = cache.get_or_compute(num, [](int n) { return factorial_expected64<T>(n); });
+      score += result.has_error() ? 0 : result.get_value();
     }
     return score;
   };
+}
+
+TEST_CASE("memo_cache - int64_t")
+{
+  run_memo_cache_benchmarks<int64_t>();
+}
+
+TEST_CASE("memo_cache - double")
+{
+  run_memo_cache_benchmarks<double>();
+}
 
-  BENCHMARK("Cube with Raw Type")
+template<typename T>
+void run_flat_map_benchmarks()
+{
+  // Instrument id -> last result: a table larger than L2 and lookups in random order, a quarter of them missing
+  constexpr size_t                 instruments = 1 << 18;
+  std::mt19937_64                  rng(42);
+  std::vector<uint64_t>            ids(instruments);
+  expected64_flat_map<uint64_t, T> flat(instruments);
+  std::unordered_map<uint64_t, T>  node_based(instruments);
+  for (uint64_t& id : ids) {
+    id = rng();
+    flat.insert_or_assign(id, static_cast<T>(id % 1000));
+    node_based[id] = static_cast<T>(id % 1000);
+  }
+  std::vector<uint64_t> lookups(instruments);
+  for (uint64_t& id : lookups) {
+    id = rng() % 4 == 0 ? rng() : ids[rng() % instruments];
+  }
+
+  BENCHMARK("Lookup with expected64_flat_map")
   {
-    T score = 0;
-    for (int num : numbers) {
-      auto result = cube<T>(static_cast<T>(num));
-      score += result;
+    T sum = 0;
+    for (uint64_t id : lookups) {
+      sum += flat.find(id).value_or(0);
     }
-    return score;
+    return sum;
   };
-}
 
-TEST_CASE("cube - int64_t")
-{
-  run_cube_benchmarks<int64_t>();
+  BENCHMARK("Lookup with std::unordered_map")
+  {
+    T sum = 0;
+    for (uint64_t id : lookups) {
+      auto it = node_based.find(id);
+      sum += it == node_based.end() ? 0 : it->second;
+    }
+    return sum;
+  };
 }
 
-TEST_CASE("cube - uint64_t")
+TEST_CASE("flat_map - int64_t")
 {
-  run_cube_benchmarks<uint64_t>();
+  run_flat_map_benchmarks<int64_t>();
 }
 
-TEST_CASE("cube - double")
+TEST_CASE("flat_map - double")
 {
-  run_cube_benchmarks<double>();
-}
\ No newline at end of file
+  run_flat_map_benchmarks<double>();
+}
@@ -0,0 +1,108 @@
+// Calls into abi_callee.cpp, which is built without LTO, through function pointers the compiler can't see through.
+// Run scripts/count_instructions.py on the binary for the instructions of each callee and driver loop.
+#include <bit>  // std::bit_cast
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <nanobench.h>
+
+#include "abi_callee.hpp"
+
+namespace
+{
+template<typename T>
+uint64_t fold(T value)
+{
+  return std::bit_cast<uint64_t>(value);
+}
+
+template<typename T>
+[[gnu::noinline]] uint64_t drive_raw(T (*fn)(T), const std::vector<T>& inputs)
+{
+  uint64_t sum = 0;
+  for (T input : inputs) {
+    sum += fold(fn(input));
+  }
+  return sum;
+}
+
+template<typename T>
+[[gnu::noinline]] uint64_t drive_expected64(expected64<T, abi_error> (*fn)(T), const std::vector<T>& inputs)
+{
+  uint64_t sum = 0;
+  for (T input : inputs) {
+    const auto result = fn(input);
+    sum += result.has_error() ? 1 : fold(result.get_value());
+  }
+  return sum;
+}
+
+template<typename Expected, typename T>
+[[gnu::noinline]] uint64_t drive_expected(Expected (*fn)(T), const std::vector<T>& inputs)
+{
+  uint64_t sum = 0;
+  for (T input : inputs) {
+    const auto result = fn(input);
+    sum += result.has_value() ? fold(*result) : 1;
+  }
+  return sum;
+}
+
+// Function pointers behind a volatile read, so calls can't be devirtualised or specialised
+template<typename F>
+F* opaque(F* fn)
+{
+  F* volatile hidden = fn;
+  return hidden;
+}
+
+template<typename T>
+void run_abi_benchmarks(const std::string& type_name, const std::vector<T>& inputs)
+{
+  ankerl::nanobench::Bench bench;
+  bench.title("Cross-TU calls returning " + type_name)
+      .unit("call")
+      .batch(static_cast<double>(inputs.size()))
+      .relative(true)
+      .minEpochIterations(200)
+      .performanceCounters(true);
+
+  bench.run("raw", [&] { ankerl::nanobench::doNotOptimizeAway(drive_raw(opaque(&abi_raw<T>), inputs)); });
+  bench.run("expected64",
+            [&] { ankerl::nanobench::doNotOptimizeAway(drive_expected64(opaque(&abi_expected64<T>), inputs)); });
+  bench.run("tl::expected",
+            [&] { ankerl::nanobench::doNotOptimizeAway(drive_expected(opaque(&abi_tl_expected<T>), inputs)); });
+#if defined(__cpp_lib_expected)
+  bench.run("std::expected",
+            [&] { ankerl::nanobench::doNotOptimizeAway(drive_expected(opaque(&abi_std_expected<T>), inputs)); });
+#endif
+  bench.run("std::optional",
+            [&] { ankerl::nanobench::doNotOptimizeAway(drive_expected(opaque(&abi_optional<T>), inputs)); });
+}
+}  // namespace
+
+int main()
+{
+  // One input in 16 is negative and comes back as an error
+  std::mt19937_64      rng(7);
+  std::vector<int64_t> numbers(4096);
+  for (int64_t& number : numbers) {
+    number = static_cast<int64_t>(rng() % 1'000'000) * (rng() % 16 == 0 ? -1 : 1);
+  }
+
+  std::vector<uint64_t>    unsigned_numbers;
+  std::vector<double>      doubles;
+  std::vector<abi_pointer> pointers;
+  for (const int64_t& number : numbers) {
+    unsigned_numbers.push_back(static_cast<uint64_t>(number));
+    doubles.push_back(static_cast<double>(number));
+    pointers.push_back(&number);
+  }
+
+  run_abi_benchmarks("int64_t", numbers);
+  run_abi_benchmarks("uint64_t", unsigned_numbers);
+  run_abi_benchmarks("double", doubles);
+  run_abi_benchmarks("pointer", pointers);
+}
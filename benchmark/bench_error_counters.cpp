@@ -0,0 +1,73 @@
+// Built twice, as expected64_benchmark_error_counters and with EXPECTED64_ERROR_COUNTERS defined as
+// expected64_benchmark_error_counters_enabled. The codegen_audit test checks that error creation stays a plain store
+// without the macro, so the two builds show what turning counters on costs.
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <nanobench.h>
+
+#include "common.hpp"
+
+int main()
+{
+#if defined(EXPECTED64_ERROR_COUNTERS)
+  const std::string mode = "error counters enabled";
+#else
+  const std::string mode = "error counters disabled";
+#endif
+
+  // Half of the inputs are negative, so every other call creates an error
+  const std::vector<int> numbers = gen_large_shuffled_numbers(1 << 12);
+
+  ankerl::nanobench::Bench bench;
+  bench.title("Error creation, " + mode)
+      .unit("call")
+      .batch(static_cast<double>(numbers.size()))
+      .minEpochIterations(200);
+
+  bench.run("cube with raw type",
+            [&]
+            {
+              int64_t score = 0;
+              for (int num : numbers) {
+                score += cube<int64_t>(num);
+              }
+              ankerl::nanobench::doNotOptimizeAway(score);
+            });
+
+  bench.run("cube with expected64",
+            [&]
+            {
+              int64_t score = 0;
+              for (int num : numbers) {
+                auto result = cube_expected64<int64_t>(num);
+                score += result.has_error() ? 0 : result.get_value();
+              }
+              ankerl::nanobench::doNotOptimizeAway(score);
+            });
+
+  bench.run("factorial with expected64",
+            [&]
+            {
+              int64_t score = 0;
+              for (int num : numbers) {
+                auto result = factorial_expected64<int64_t>(num);
+                score += result.has_error() ? 0 : result.get_value();
+              }
+              ankerl::nanobench::doNotOptimizeAway(score);
+            });
+
+#if defined(EXPECTED64_ERROR_COUNTERS)
+  const error_counters_snapshot snapshot = snapshot_error_counters();
+  std::printf("\n%-60s %10s %14s\n", "call site", "code", "count");
+  for (const error_count& entry : snapshot.counts) {
+    const std::string site = std::string(entry.location.file_name()) + ":" + std::to_string(entry.location.line());
+    std::printf("%-60s %10llu %14llu\n",
+                site.c_str(),
+                static_cast<unsigned long long>(entry.code),
+                static_cast<unsigned long long>(entry.count));
+  }
+#endif
+}
@@ -1,32 +1,290 @@
-#include <atomic>
+// The nanobench matrix: {int64_t, uint64_t, double, pointer} x {raw, std::optional, tl::expected, std::expected,
+// expected64} x {factorial, cube, pointer chase}, plus the error rate sweep and the batch kernels on every backend the
+// CPU supports. Every table is printed as it runs and all results go into a single JSON report,
+// expected64_nanobench.json or the path given as the first argument.
+// Factorial and cube are arithmetic and skip pointers, std::expected needs a C++23 standard library.
+#include <bit>  // for std::bit_cast
+#include <cstdint>
 #include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
+#include <expected64/batch_dispatch.hpp>
 #include <nanobench.h>
 
 #include "common.hpp"
 
-int main()
-{
-  int y = 0;
-
-  int64_t test_value = 5;
-
-  auto bench = [&](auto func, const char* description, int num)
-  {
-    std::ofstream out {std::string(description) + ".json"};
-    ankerl::nanobench::Bench()
-        .minEpochIterations(1000000)
-        .run(description,
-             [&]
-             {
-               auto result = func(num);
-               ankerl::nanobench::doNotOptimizeAway(result);
-             })
-        .render(ankerl::nanobench::templates::pyperf(), out);
-  };
-
-  bench(factorial_raw<int64_t>, "factorial-raw-int", test_value);
-  bench(factorial_optional<int64_t>, "factorial-optional-int", test_value);
-  bench(factorial_expected<int64_t>, "factorial-tlexpected-int", test_value);
-  bench(factorial_expected64<int64_t>, "factorial-expected64-int", test_value);
-}
\ No newline at end of file
+namespace
+{
+std::vector<ankerl::nanobench::Result> all_results;
+
+void keep(const ankerl::nanobench::Bench& bench)
+{
+  all_results.insert(all_results.end(), bench.results().begin(), bench.results().end());
+}
+
+template<typename T>
+uint64_t fold(T value)
+{
+  if constexpr (std::is_pointer_v<T>)
+    return reinterpret_cast<uintptr_t>(value);
+  else
+    return std::bit_cast<uint64_t>(value);
+}
+
+template<typename T>
+bool ok(const expected64<T, error_code>& result)
+{
+  return !result.has_error();
+}
+
+template<typename R>
+bool ok(const R& result)
+{
+  return result.has_value();
+}
+
+template<typename T>
+T value_of(const expected64<T, error_code>& result)
+{
+  return result.get_value();
+}
+
+template<typename R>
+auto value_of(const R& result)
+{
+  return *result;
+}
+
+ankerl::nanobench::Bench make_bench(const std::string& title, size_t batch)
+{
+  ankerl::nanobench::Bench bench;
+  bench.title(title).relative(true).unit("call").batch(static_cast<double>(batch)).performanceCounters(true);
+  return bench;
+}
+
+// f over every input: raw results are summed unchecked, the others are checked first
+template<typename T, typename F>
+void run_checked(ankerl::nanobench::Bench& bench, const char* name, const std::vector<int>& numbers, F f)
+{
+  bench.run(name,
+            [&]
+            {
+              uint64_t score = 0;
+              for (int num : numbers) {
+                const auto result = f(static_cast<T>(num));
+                if constexpr (std::is_same_v<std::remove_const_t<decltype(result)>, T>) {
+                  score += fold(result);
+                } else {
+                  score += ok(result) ? fold(value_of(result)) : 1;
+                }
+              }
+              ankerl::nanobench::doNotOptimizeAway(score);
+            });
+}
+
+template<typename T>
+void run_arithmetic(const std::string& type_name, const std::vector<int>& numbers)
+{
+  auto factorial_bench = make_bench("factorial " + type_name, numbers.size());
+  run_checked<T>(factorial_bench, "raw", numbers, factorial_raw<T>);
+  run_checked<T>(factorial_bench, "std::optional", numbers, factorial_optional<T>);
+  run_checked<T>(factorial_bench, "optional64", numbers, factorial_optional64<T>);
+  run_checked<T>(factorial_bench, "tl::expected", numbers, factorial_expected<T>);
+#if defined(__cpp_lib_expected)
+  run_checked<T>(factorial_bench, "std::expected", numbers, factorial_std_expected<T>);
+#endif
+  run_checked<T>(factorial_bench, "expected64", numbers, factorial_expected64<T>);
+  keep(factorial_bench);
+
+  auto cube_bench = make_bench("cube " + type_name, numbers.size());
+  run_checked<T>(cube_bench, "raw", numbers, [](T value) { return cube<T>(value); });
+  run_checked<T>(cube_bench, "std::optional", numbers, [](T value) { return cube_optional<T>(value); });
+  run_checked<T>(cube_bench, "tl::expected", numbers, [](T value) { return cube_expected<T>(value); });
+#if defined(__cpp_lib_expected)
+  run_checked<T>(cube_bench, "std::expected", numbers, [](T value) { return cube_std_expected<T>(value); });
+#endif
+  run_checked<T>(cube_bench, "expected64", numbers, [](T value) { return cube_expected64<T>(value); });
+  keep(cube_bench);
+}
+
+// One step per node. For pointers the result is the next node, so every check sits on the load chain, other types
+// add up the node values and follow the link
+template<typename T, typename F>
+void run_chase(ankerl::nanobench::Bench& bench, const char* name, const std::vector<chase_node>& nodes, F f)
+{
+  bench.run(name,
+            [&]
+            {
+              const chase_node* node = nodes.data();
+              uint64_t          score = 0;
+              for (size_t i = 0; i < nodes.size(); ++i) {
+                const auto result = f(node);
+                if constexpr (std::is_same_v<std::remove_const_t<decltype(result)>, T>) {
+                  if constexpr (std::is_pointer_v<T>) {
+                    node = result != nullptr ? result : node->next;
+                  } else {
+                    score += fold(result);
+                    node = node->next;
+                  }
+                } else if constexpr (std::is_pointer_v<T>) {
+                  node = ok(result) ? value_of(result) : node->next;
+                } else {
+                  score += ok(result) ? fold(value_of(result)) : 1;
+                  node = node->next;
+                }
+              }
+              ankerl::nanobench::doNotOptimizeAway(score);
+              ankerl::nanobench::doNotOptimizeAway(node);
+            });
+}
+
+template<typename T>
+void run_pointer_chase(const std::string& type_name, const std::vector<chase_node>& nodes)
+{
+  auto bench = make_bench("pointer chase " + type_name, nodes.size());
+  run_chase<T>(bench, "raw", nodes, chase_raw<T>);
+  run_chase<T>(bench, "std::optional", nodes, chase_optional<T>);
+  run_chase<T>(bench, "tl::expected", nodes, chase_expected<T>);
+#if defined(__cpp_lib_expected)
+  run_chase<T>(bench, "std::expected", nodes, chase_std_expected<T>);
+#endif
+  run_chase<T>(bench, "expected64", nodes, chase_expected64<T>);
+  keep(bench);
+}
+
+// One table per error rate and pattern, relative to the raw loop
+template<typename T>
+void run_error_rate_sweep(const std::string& type_name)
+{
+  for (double rate : error_rates) {
+    for (error_pattern pattern : error_patterns) {
+      if (rate <= 0.0 && pattern != error_pattern::uniform) {
+        continue;
+      }
+      const std::vector<int> numbers = gen_numbers_with_errors(1 << 12, rate, pattern);
+
+      ankerl::nanobench::Bench bench;
+      bench.title("cube " + type_name + " [" + error_config_name(rate, pattern) + "]")
+          .relative(true)
+          .unit("input")
+          .batch(static_cast<double>(numbers.size()));
+      bench.run("raw",
+                [&]
+                {
+                  T score = 0;
+                  for (int num : numbers) {
+                    score += cube<T>(static_cast<T>(num));
+                  }
+                  ankerl::nanobench::doNotOptimizeAway(score);
+                });
+      bench.run("expected64 branchy",
+                [&]
+                {
+                  T score = 0;
+                  for (int num : numbers) {
+                    auto result = cube_expected64<T>(static_cast<T>(num));
+                    score += result.has_error() ? 0 : result.get_value();
+                  }
+                  ankerl::nanobench::doNotOptimizeAway(score);
+                });
+      bench.run("expected64 branchless",
+                [&]
+                {
+                  T score = 0;
+                  for (int num : numbers) {
+                    score += value_or_zero_branchless<T>(cube_expected64_branchless<T>(static_cast<T>(num)));
+                  }
+                  ankerl::nanobench::doNotOptimizeAway(score);
+                });
+      bench.run("std::optional",
+                [&]
+                {
+                  T score = 0;
+                  for (int num : numbers) {
+                    auto result = cube_optional<T>(static_cast<T>(num));
+                    score += result.has_value() ? result.value() : 0;
+                  }
+                  ankerl::nanobench::doNotOptimizeAway(score);
+                });
+      keep(bench);
+    }
+  }
+}
+
+// Every span kernel on every backend this CPU supports, over words with 1% errors. The simd backend is compiled for the
+// baseline instruction set, so its rows show what hosts without hand-written kernels get.
+template<typename T>
+void run_batch_backends(const std::string& type_name)
+{
+  using result = expected64<T, error_code>;
+  const std::vector<int> numbers = gen_numbers_with_errors(1 << 14, 0.01, error_pattern::uniform);
+  std::vector<uint64_t>  words;
+  for (int num : numbers) {
+    words.push_back(num < 0 ? result(error_code::error).to_bits() : result(static_cast<T>(num)).to_bits());
+  }
+  const size_t          n = words.size();
+  std::vector<uint64_t> bits((n + 63) / 64), out(n), values(n), payloads(n), valid(n);
+  // batch_sum() stops at the first error, so it adds up the valid words
+  const size_t kept = batch_kernels<result>(batch_backend::scalar).compact(words.data(), n, valid.data());
+
+  ankerl::nanobench::Bench error_bits = make_bench("batch error bits " + type_name, n);
+  ankerl::nanobench::Bench sum = make_bench("batch sum " + type_name, kept);
+  ankerl::nanobench::Bench compact = make_bench("batch compact " + type_name, n);
+  ankerl::nanobench::Bench decode = make_bench("batch decode " + type_name, n);
+  ankerl::nanobench::Bench encode = make_bench("batch encode " + type_name, n);
+  for (batch_backend backend :
+       {batch_backend::scalar, batch_backend::simd, batch_backend::avx2, batch_backend::avx512}) {
+    if (!batch_backend_supported(backend)) {
+      continue;
+    }
+    const auto& kernels = batch_kernels<result>(backend);
+    const char* name = batch_backend_name(backend);
+    error_bits.run(name,
+                   [&] { ankerl::nanobench::doNotOptimizeAway(kernels.error_bits(words.data(), n, bits.data())); });
+    sum.run(name, [&] { ankerl::nanobench::doNotOptimizeAway(kernels.sum(valid.data(), kept).to_bits()); });
+    compact.run(name, [&] { ankerl::nanobench::doNotOptimizeAway(kernels.compact(words.data(), n, out.data())); });
+    decode.run(name,
+               [&]
+               {
+                 ankerl::nanobench::doNotOptimizeAway(
+                     kernels.decode(words.data(), n, values.data(), payloads.data(), bits.data()));
+               });
+    encode.run(name, [&] { kernels.encode(values.data(), payloads.data(), bits.data(), n, out.data()); });
+  }
+  for (const auto* bench : {&error_bits, &sum, &compact, &decode, &encode}) {
+    keep(*bench);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const std::string report = argc > 1 ? argv[1] : "expected64_nanobench.json";
+
+  // Half of the inputs are negative and fail, the cycle spans 1 MB so each step misses L1
+  const std::vector<int>        numbers = gen_shuffled_numbers();
+  const std::vector<chase_node> nodes = gen_chase_cycle(1 << 16);
+
+  run_arithmetic<int64_t>("int64_t", numbers);
+  run_arithmetic<uint64_t>("uint64_t", numbers);
+  run_arithmetic<double>("double", numbers);
+
+  run_pointer_chase<int64_t>("int64_t", nodes);
+  run_pointer_chase<uint64_t>("uint64_t", nodes);
+  run_pointer_chase<double>("double", nodes);
+  run_pointer_chase<const chase_node*>("pointer", nodes);
+
+  run_error_rate_sweep<int64_t>("int64_t");
+  run_error_rate_sweep<double>("double");
+
+  run_batch_backends<int64_t>("int64_t");
+  run_batch_backends<double>("double");
+
+  std::ofstream out(report);
+  ankerl::nanobench::render(ankerl::nanobench::templates::json(), all_results, out);
+  std::cout << "Wrote " << all_results.size() << " results to " << report << "\n";
+}
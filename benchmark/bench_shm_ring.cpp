@@ -0,0 +1,131 @@
+// One-way latency of shm_ring between two processes. The parent publishes steady_clock timestamps at a fixed
+// interval, a forked child busy-polls a reader and records how long after its timestamp each message arrived. Both
+// read CLOCK_MONOTONIC, so the difference is the publish-to-read latency, clock reads included.
+//
+//   expected64_benchmark_shm_ring [--messages N] [--interval-ns N] [--capacity N]
+//
+// One message in 64 is an error, which carries no timestamp and is only counted. With fewer cores than the two
+// busy-polling processes need, the latencies are scheduler time slices rather than the ring's.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <expected64/shm_ring.hpp>
+
+namespace
+{
+enum class error_code : uint32_t
+{
+  stale_quote = 1
+};
+
+using result = expected64<int64_t, error_code>;
+
+int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int run_reader(const std::string& name, uint64_t messages, int ready_fd)
+{
+  shm_ring_reader<result> in(name);
+  const char              ready = 1;
+  if (::write(ready_fd, &ready, 1) != 1) {
+    return 1;
+  }
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(messages);
+  uint64_t errors = 0;
+  while (in.position() < messages) {
+    if (auto message = in.try_read()) {
+      const int64_t arrived = now_ns();
+      if (message->has_error()) {
+        ++errors;  // Carries no timestamp
+      } else {
+        latencies.push_back(arrived - message->get_value());
+      }
+    }
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&](double p)
+  { return latencies.empty() ? 0 : latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))]; };
+  std::printf("| messages | errors | lost | p50 ns | p90 ns | p99 ns | p99.9 ns | max ns |\n");
+  std::printf("|---------:|-------:|-----:|-------:|-------:|-------:|---------:|-------:|\n");
+  std::printf("| %8llu | %6llu | %4llu | %6lld | %6lld | %6lld | %8lld | %6lld |\n",
+              static_cast<unsigned long long>(messages),
+              static_cast<unsigned long long>(errors),
+              static_cast<unsigned long long>(in.lost()),
+              static_cast<long long>(percentile(0.5)),
+              static_cast<long long>(percentile(0.9)),
+              static_cast<long long>(percentile(0.99)),
+              static_cast<long long>(percentile(0.999)),
+              static_cast<long long>(percentile(1.0)));
+  std::fflush(stdout);
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  uint64_t messages = 1000000;
+  int64_t  interval_ns = 1000;
+  size_t   capacity = 4096;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+      messages = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--interval-ns") == 0 && i + 1 < argc) {
+      interval_ns = std::strtoll(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+      capacity = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "usage: %s [--messages N] [--interval-ns N] [--capacity N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  const std::string name = "/expected64-bench-" + std::to_string(::getpid());
+  shm_ring_writer<result>::remove(name);
+  shm_ring_writer<result> out(name, capacity);
+
+  // The child attaches its reader before the first message goes out
+  int ready[2];
+  if (::pipe(ready) != 0) {
+    std::perror("pipe");
+    return 1;
+  }
+  const pid_t child = ::fork();
+  if (child == 0) {
+    ::close(ready[0]);
+    ::_exit(run_reader(name, messages, ready[1]));
+  }
+  ::close(ready[1]);
+  char byte = 0;
+  if (::read(ready[0], &byte, 1) != 1) {
+    std::fprintf(stderr, "reader failed to attach\n");
+    return 1;
+  }
+
+  int64_t next = now_ns();
+  for (uint64_t i = 0; i < messages; ++i) {
+    while (now_ns() < next) {
+    }
+    next += interval_ns;
+    out.publish(i % 64 == 63 ? result(error_code::stale_quote) : result(now_ns()));
+  }
+
+  int status = 0;
+  ::waitpid(child, &status, 0);
+  shm_ring_writer<result>::remove(name);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
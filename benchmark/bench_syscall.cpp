@@ -0,0 +1,69 @@
+// The sys:: wrappers against libc plus errno, on cheap system calls where the error reporting is a visible part of the
+// cost: lseek(SEEK_CUR), a 64-byte pread from a cached file and a read on a closed descriptor. The libc loops turn
+// -1 into the same expected64<int64_t, std::errc> by reading errno, as a caller of the libc functions would.
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <expected64/syscall.hpp>
+#include <nanobench.h>
+
+namespace
+{
+sys::result libc_result(long ret)
+{
+  return ret < 0 ? sys::result(static_cast<std::errc>(errno)) : sys::result(int64_t {ret});
+}
+
+template<typename F>
+void run(ankerl::nanobench::Bench& bench, const char* name, F call)
+{
+  bench.run(name,
+            [&]
+            {
+              uint64_t sum = 0;
+              for (int i = 0; i < 64; ++i) {
+                const sys::result result = call();
+                sum += result.has_error() ? static_cast<uint64_t>(result.get_error()) : 1;
+              }
+              ankerl::nanobench::doNotOptimizeAway(sum);
+            });
+}
+}  // namespace
+
+int main()
+{
+  char path[] = "/tmp/expected64_bench_syscall_XXXXXX";
+  const int fd = ::mkstemp(path);
+  if (fd < 0) {
+    std::perror("mkstemp");
+    return 1;
+  }
+  ::unlink(path);
+  char block[4096] {};
+  if (::write(fd, block, sizeof(block)) != static_cast<ssize_t>(sizeof(block))) {
+    std::perror("write");
+    return 1;
+  }
+
+  // A descriptor number that is certainly closed
+  const int closed = ::dup(fd);
+  ::close(closed);
+
+  char buffer[64];
+  ankerl::nanobench::Bench bench;
+  bench.title("System calls, 64 per batch").relative(true).unit("call").batch(64).performanceCounters(true);
+
+  run(bench, "lseek libc + errno", [&] { return libc_result(::lseek(fd, 0, SEEK_CUR)); });
+  run(bench, "lseek sys", [&] { return sys::lseek(fd, 0, SEEK_CUR); });
+  run(bench, "pread libc + errno", [&] { return libc_result(::pread(fd, buffer, sizeof(buffer), 128)); });
+  run(bench, "pread sys", [&] { return sys::pread(fd, buffer, sizeof(buffer), 128); });
+  run(bench, "read EBADF libc + errno", [&] { return libc_result(::read(closed, buffer, sizeof(buffer))); });
+  run(bench, "read EBADF sys", [&] { return sys::read(closed, buffer, sizeof(buffer)); });
+
+  ::close(fd);
+}
@@ -0,0 +1,260 @@
+// Check, sum and transform over arrays from 4 KB to 4 GB, for expected64, tl::expected, std::optional and raw int64_t.
+// Sizes are those of the expected64 array, the other layouts hold the same number of elements. The timing is done
+// here rather than with nanobench, which would repeat a multi-gigabyte pass for every epoch.
+//
+//   expected64_benchmark_working_set [--max-bytes N] [--huge-pages]
+//
+// --huge-pages maps the arrays with MAP_HUGETLB when huge pages are reserved, and asks for transparent huge pages
+// otherwise. Sizes stop where the arrays would take more than half of physical memory.
+#include <algorithm>
+#include <bit>  // std::popcount
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <string>
+
+#include <unistd.h>
+#if defined(__linux__)
+#  include <sys/mman.h>
+#endif
+
+#include <expected64/batch.hpp>
+#include <expected64/expected64.hpp>
+#include <tl/expected.hpp>
+
+#include "common.hpp"
+
+namespace
+{
+bool use_huge_pages = false;
+
+// Page-aligned buffer of n elements, from mmap on Linux so huge pages can be requested
+template<typename R>
+class buffer
+{
+  R*     data_ = nullptr;
+  size_t bytes = 0;
+
+public:
+  explicit buffer(size_t n)
+      : bytes((n * sizeof(R) + 4095) / 4096 * 4096)
+  {
+#if defined(__linux__)
+    void* addr = MAP_FAILED;
+    if (use_huge_pages) {
+      const size_t huge_bytes = (bytes + (2U << 20) - 1) / (2U << 20) * (2U << 20);
+      addr = ::mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (addr != MAP_FAILED) {
+        bytes = huge_bytes;
+      }
+    }
+    if (addr == MAP_FAILED) {
+      addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (addr == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      if (use_huge_pages) {
+        ::madvise(addr, bytes, MADV_HUGEPAGE);
+      }
+    }
+    data_ = static_cast<R*>(addr);
+#else
+    data_ = static_cast<R*>(std::aligned_alloc(4096, bytes));
+    if (data_ == nullptr) {
+      throw std::bad_alloc();
+    }
+#endif
+  }
+
+  buffer(const buffer&) = delete;
+  buffer& operator=(const buffer&) = delete;
+
+  ~buffer()
+  {
+#if defined(__linux__)
+    ::munmap(data_, bytes);
+#else
+    std::free(data_);
+#endif
+  }
+
+  R* data() const noexcept { return data_; }
+};
+
+using expected64_result = expected64<int64_t, error_code>;
+using tl_result = tl::expected<int64_t, error_code>;
+using optional_result = std::optional<int64_t>;
+
+// Raw values mark errors with a negative number
+int64_t make(int64_t value, bool error, int64_t*)
+{
+  return error ? -1 : value;
+}
+expected64_result make(int64_t value, bool error, expected64_result*)
+{
+  return error ? expected64_result(error_code::error) : expected64_result(value);
+}
+tl_result make(int64_t value, bool error, tl_result*)
+{
+  return error ? tl_result(tl::unexpect, error_code::error) : tl_result(value);
+}
+optional_result make(int64_t value, bool error, optional_result*)
+{
+  return error ? std::nullopt : optional_result(value);
+}
+
+bool failed(int64_t r)
+{
+  return r < 0;
+}
+bool failed(const expected64_result& r)
+{
+  return r.has_error();
+}
+template<typename R>
+bool failed(const R& r)
+{
+  return !r.has_value();
+}
+
+int64_t value_of(int64_t r)
+{
+  return r;
+}
+int64_t value_of(const expected64_result& r)
+{
+  return r.get_value();
+}
+template<typename R>
+int64_t value_of(const R& r)
+{
+  return *r;
+}
+
+template<typename R>
+size_t count_errors(const R* data, size_t n)
+{
+  size_t errors = 0;
+  for (size_t i = 0; i < n; ++i) {
+    errors += failed(data[i]);
+  }
+  return errors;
+}
+
+// expected64 arrays are plain words, checked 64 at a time
+size_t count_errors(const expected64_result* data, size_t n)
+{
+  static_assert(sizeof(expected64_result) == sizeof(uint64_t));
+  const auto* words = reinterpret_cast<const uint64_t*>(data);
+  size_t      errors = 0;
+  for (size_t i = 0; i < n; i += 64) {
+    const uint64_t mask = batch_error_mask<expected64_result>(words + i, std::min<size_t>(64, n - i));
+    errors += static_cast<size_t>(std::popcount(mask));
+  }
+  return errors;
+}
+
+template<typename R>
+int64_t sum(const R* data, size_t n)
+{
+  int64_t total = 0;
+  for (size_t i = 0; i < n; ++i) {
+    total += failed(data[i]) ? 0 : value_of(data[i]);
+  }
+  return total;
+}
+
+template<typename R>
+void transform(const R* in, R* out, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = failed(in[i]) ? in[i] : make(value_of(in[i]) * 3 + 1, false, static_cast<R*>(nullptr));
+  }
+}
+
+template<typename F>
+double best_seconds(F&& f)
+{
+  using clock = std::chrono::steady_clock;
+  double     best = 1e300;
+  const auto start = clock::now();
+  for (int runs = 0; runs < 3 || clock::now() - start < std::chrono::milliseconds(100); ++runs) {
+    const auto before = clock::now();
+    f();
+    best = std::min(best, std::chrono::duration<double>(clock::now() - before).count());
+  }
+  return best;
+}
+
+void report(size_t working_set, const char* layout, const char* op, size_t n, size_t bytes, double seconds)
+{
+  std::printf("| %11zu | %-13s | %-9s | %8.3f | %7.2f |\n",
+              working_set,
+              layout,
+              op,
+              seconds * 1e9 / static_cast<double>(n),
+              static_cast<double>(bytes) / seconds / 1e9);
+}
+
+template<typename R>
+void run_layout(const char* layout, size_t working_set)
+{
+  const size_t n = working_set / sizeof(uint64_t);
+  buffer<R>    in(n);
+  buffer<R>    out(n);
+  uint64_t     state = 0x9E37'79B9'7F4A'7C15;
+  for (size_t i = 0; i < n; ++i) {
+    // xorshift, one error in 64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    in.data()[i] = make(static_cast<int64_t>(state >> 44), (state & 63) == 0, static_cast<R*>(nullptr));
+    out.data()[i] = in.data()[i];
+  }
+
+  volatile size_t  errors = 0;
+  volatile int64_t total = 0;
+  report(working_set, layout, "check", n, n * sizeof(R), best_seconds([&] { errors = count_errors(in.data(), n); }));
+  report(working_set, layout, "sum", n, n * sizeof(R), best_seconds([&] { total = sum(in.data(), n); }));
+  report(working_set,
+         layout,
+         "transform",
+         n,
+         2 * n * sizeof(R),
+         best_seconds([&] { transform(in.data(), out.data(), n); }));
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t max_bytes = size_t {4} << 30;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--huge-pages") == 0) {
+      use_huge_pages = true;
+    } else if (std::strcmp(argv[i], "--max-bytes") == 0 && i + 1 < argc) {
+      max_bytes = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "usage: %s [--max-bytes N] [--huge-pages]\n", argv[0]);
+      return 1;
+    }
+  }
+  // Input and output arrays of the 16-byte layouts take four times the working set
+  const long pages = ::sysconf(_SC_PHYS_PAGES);
+  const long page_size = ::sysconf(_SC_PAGESIZE);
+  if (pages > 0 && page_size > 0) {
+    max_bytes = std::min(max_bytes, static_cast<size_t>(pages) * static_cast<size_t>(page_size) / 2 / 4);
+  }
+
+  std::printf("| working set | layout        | operation | ns/elem  | GB/s    |\n");
+  std::printf("|------------:|---------------|-----------|---------:|--------:|\n");
+  for (size_t working_set = 4096; working_set <= max_bytes; working_set *= 4) {
+    run_layout<int64_t>("raw", working_set);
+    run_layout<expected64_result>("expected64", working_set);
+    run_layout<tl_result>("tl::expected", working_set);
+    run_layout<optional_result>("std::optional", working_set);
+  }
+}
@@ -1,9 +1,18 @@
 #pragma once
+#include <algorithm>  // for std::shuffle
+#include <bit>  // for std::bit_cast
+#include <numeric>  // for std::iota
 #include <optional>
 #include <random>  // for std::mt19937 and std::random_device
+#include <string>
+#include <type_traits>
 #include <vector>
+#if __has_include(<expected>)
+#  include <expected>
+#endif
 
 #include <expected64/expected64.hpp>
+#include <expected64/optional64.hpp>
 #include <tl/expected.hpp>
 
 std::vector<int> gen_shuffled_numbers()
@@ -22,6 +31,91 @@ std::vector<int> gen_shuffled_numbers()
   return numbers;
 }
 
+// gen_shuffled_numbers() repeated until there are at least n inputs
+std::vector<int> gen_large_shuffled_numbers(size_t n)
+{
+  std::vector<int> numbers;
+  numbers.reserve(n);
+  while (numbers.size() < n) {
+    std::vector<int> block = gen_shuffled_numbers();
+    numbers.insert(numbers.end(), block.begin(), block.end());
+  }
+  return numbers;
+}
+
+// How the errors of gen_numbers_with_errors() are spread over the inputs
+enum class error_pattern
+{
+  uniform,  // Independent positions
+  bursty,  // Runs of 64 consecutive errors
+  periodic  // Every k-th input
+};
+
+const double        error_rates[] = {0.0, 0.001, 0.01, 0.1, 0.5};
+const error_pattern error_patterns[] = {error_pattern::uniform, error_pattern::bursty, error_pattern::periodic};
+
+std::string error_config_name(double error_rate, error_pattern pattern)
+{
+  const char* pattern_names[] = {"uniform", "bursty", "periodic"};
+  std::string rate = std::to_string(error_rate * 100);
+  rate.erase(rate.find_last_not_of('0') + 1);
+  if (rate.back() == '.') {
+    rate.pop_back();
+  }
+  return rate + "% " + pattern_names[static_cast<int>(pattern)];
+}
+
+// n inputs in [0, 10), of which a fraction error_rate are replaced by negative numbers, i.e. errors
+std::vector<int> gen_numbers_with_errors(size_t n, double error_rate, error_pattern pattern)
+{
+  std::mt19937                       g(12345);
+  std::uniform_int_distribution<int> valid(0, 9);
+  std::uniform_int_distribution<int> invalid(-10, -1);
+
+  std::vector<int> numbers(n);
+  for (int& num : numbers) {
+    num = valid(g);
+  }
+
+  const auto errors = static_cast<size_t>(error_rate * static_cast<double>(n) + 0.5);
+  if (errors == 0) {
+    return numbers;
+  }
+  switch (pattern) {
+    case error_pattern::uniform: {
+      std::vector<size_t> positions(n);
+      std::iota(positions.begin(), positions.end(), 0);
+      std::shuffle(positions.begin(), positions.end(), g);
+      for (size_t i = 0; i < errors; ++i) {
+        numbers[positions[i]] = invalid(g);
+      }
+      break;
+    }
+    case error_pattern::bursty: {
+      constexpr size_t burst_length = 64;
+      for (size_t placed = 0; placed < errors;) {
+        const size_t start = g() % n;
+        for (size_t i = 0; i < burst_length && placed < errors; ++i) {
+          int& num = numbers[(start + i) % n];
+          if (num >= 0) {
+            num = invalid(g);
+            ++placed;
+          }
+        }
+      }
+      break;
+    }
+    case error_pattern::periodic: {
+      const size_t period = n / errors;
+      for (size_t i = period - 1, placed = 0; i < n && placed < errors; i += period, ++placed) {
+        numbers[i] = invalid(g);
+      }
+      break;
+    }
+  }
+  return numbers;
+}
+
 enum class error_code
 {
   no_error = 0,
@@ -56,6 +150,14 @@ std::optional<T> factorial_optional(T n)
   return factorial(n);
 }
 
+template<typename T>
+optional64<T> factorial_optional64(T n)
+{
+  if (n < 0)
+    return std::nullopt;
+  return factorial(n);
+}
+
 template<typename T>
 tl::expected<T, error_code> factorial_expected(T n)
 {
@@ -64,6 +166,16 @@ tl::expected<T, error_code> factorial_expected(T n)
   return factorial(n);
 }
 
+#if defined(__cpp_lib_expected)
+template<typename T>
+std::expected<T, error_code> factorial_std_expected(T n)
+{
+  if (n < 0)
+    return std::unexpected {error_code::error};
+  return factorial(n);
+}
+#endif
+
 template<typename T>
 expected64<T, error_code> factorial_expected64(T n)
 {
@@ -88,10 +200,119 @@ std::optional<T> cube_optional(const T& value)
   return cube(value);
 }
 
+template<typename T>
+tl::expected<T, error_code> cube_expected(const T& value)
+{
+  if (value < 0)
+    return tl::unexpected {error_code::error};
+  return cube(value);
+}
+
+#if defined(__cpp_lib_expected)
+template<typename T>
+std::expected<T, error_code> cube_std_expected(const T& value)
+{
+  if (value < 0)
+    return std::unexpected {error_code::error};
+  return cube(value);
+}
+#endif
+
 template<typename T>
 expected64<T, error_code> cube_expected64(const T& value)
 {
   if (value < 0)
     return expected64<T, error_code>(error_code::error);
   return expected64<T, error_code>(cube(value));
-}
\ No newline at end of file
+}
+
+// cube_expected64() without the branch: the value and error words are selected with a mask
+template<typename T>
+expected64<T, error_code> cube_expected64_branchless(const T& value)
+{
+  using result = expected64<T, error_code>;
+  const uint64_t error_mask = static_cast<uint64_t>(0) - static_cast<uint64_t>(value < 0);
+  const uint64_t value_bits = result(value * value * value).to_bits();
+  return result::from_bits((value_bits & ~error_mask) | (result::error_bits(error_code::error) & error_mask));
+}
+
+// The value, or zero for errors, using error_msb() instead of a branch
+template<typename T>
+T value_or_zero_branchless(expected64<T, error_code> result)
+{
+  const uint64_t keep = (expected64<T, error_code>::error_msb(result.to_bits()) >> 63) - 1;
+  return std::bit_cast<T>(result.to_bits() & keep);
+}
+
+// A shuffled cycle of nodes, every 16th one broken, for latency-bound chains of checked results
+struct chase_node
+{
+  const chase_node* next;
+  int64_t           value;  // Negative for broken nodes
+};
+
+std::vector<chase_node> gen_chase_cycle(size_t n)
+{
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 g(54321);
+  std::shuffle(order.begin() + 1, order.end(), g);
+
+  std::vector<chase_node> nodes(n);
+  for (size_t i = 0; i < n; ++i) {
+    nodes[order[i]] = chase_node {&nodes[order[(i + 1) % n]], i % 16 == 15 ? -1 : static_cast<int64_t>(i % 1000)};
+  }
+  return nodes;
+}
+
+// What a step yields: the next node for pointers, the node's value otherwise
+template<typename T>
+T chase_payload(const chase_node* node)
+{
+  if constexpr (std::is_pointer_v<T>)
+    return node->next;
+  else
+    return static_cast<T>(node->value);
+}
+
+template<typename T>
+T chase_raw(const chase_node* node)
+{
+  if (node->value < 0)
+    return T {};  // Error case, a null pointer or zero
+  return chase_payload<T>(node);
+}
+
+template<typename T>
+std::optional<T> chase_optional(const chase_node* node)
+{
+  if (node->value < 0)
+    return std::nullopt;
+  return chase_payload<T>(node);
+}
+
+template<typename T>
+tl::expected<T, error_code> chase_expected(const chase_node* node)
+{
+  if (node->value < 0)
+    return tl::unexpected {error_code::error};
+  return chase_payload<T>(node);
+}
+
+#if defined(__cpp_lib_expected)
+template<typename T>
+std::expected<T, error_code> chase_std_expected(const chase_node* node)
+{
+  if (node->value < 0)
+    return std::unexpected {error_code::error};
+  return chase_payload<T>(node);
+}
+#endif
+
+template<typename T>
+expected64<T, error_code> chase_expected64(const chase_node* node)
+{
+  if (node->value < 0)
+    return expected64<T, error_code>(error_code::error);
+  return expected64<T, error_code>(chase_payload<T>(node));
+}
@@ -0,0 +1,134 @@
+// Compiled, not run, by scripts/footprint_report.py: FOOTPRINT_COMBINATIONS distinct error enums times the four value
+// types, each with its own producer and consumer, as expected64 or, with FOOTPRINT_TL_EXPECTED, tl::expected.
+#include <array>
+#include <bit>  // std::bit_cast
+#include <cstdint>
+#include <type_traits>
+#include <utility>  // std::integer_sequence
+
+#if defined(FOOTPRINT_TL_EXPECTED)
+#  include <tl/expected.hpp>
+#else
+#  include <expected64/expected64.hpp>
+#endif
+
+#if !defined(FOOTPRINT_COMBINATIONS)
+#  define FOOTPRINT_COMBINATIONS 64
+#endif
+
+namespace
+{
+// A distinct error type per index
+template<int I>
+struct site
+{
+  enum class error : uint8_t
+  {
+    rejected = 1,
+    overflow
+  };
+};
+
+#if defined(FOOTPRINT_TL_EXPECTED)
+template<typename T, typename E>
+using result = tl::expected<T, E>;
+
+template<typename T, typename E>
+result<T, E> fail(E error)
+{
+  return tl::unexpected {error};
+}
+
+template<typename R>
+bool ok(const R& r)
+{
+  return r.has_value();
+}
+
+template<typename R>
+auto value_of(const R& r)
+{
+  return *r;
+}
+
+template<typename R>
+auto error_of(const R& r)
+{
+  return r.error();
+}
+#else
+template<typename T, typename E>
+using result = expected64<T, E>;
+
+template<typename T, typename E>
+result<T, E> fail(E error)
+{
+  return result<T, E>(error);
+}
+
+template<typename R>
+bool ok(const R& r)
+{
+  return !r.has_error();
+}
+
+template<typename R>
+auto value_of(const R& r)
+{
+  return r.get_value();
+}
+
+template<typename R>
+auto error_of(const R& r)
+{
+  return r.get_error();
+}
+#endif
+
+template<typename T>
+uint64_t fold(T value)
+{
+  if constexpr (std::is_pointer_v<T>)
+    return reinterpret_cast<uintptr_t>(value);
+  else
+    return std::bit_cast<uint64_t>(value);
+}
+
+template<int I, typename T>
+[[gnu::noinline]] result<T, typename site<I>::error> produce(T input)
+{
+  using error = typename site<I>::error;
+  if constexpr (std::is_pointer_v<T>) {
+    if (input == nullptr)
+      return fail<T>(error::rejected);
+    return input + I;
+  } else {
+    if (std::is_signed_v<T> && input < T {0})
+      return fail<T>(error::rejected);
+    if (input > T {1000000})
+      return fail<T>(error::overflow);
+    return input * T {3} + T {I};
+  }
+}
+
+template<int I, typename T>
+[[gnu::noinline]] uint64_t consume(T input)
+{
+  const auto r = produce<I, T>(input);
+  return ok(r) ? fold(value_of(r)) : static_cast<uint64_t>(error_of(r));
+}
+
+template<typename T, int... I>
+constexpr auto consumers(std::integer_sequence<int, I...>)
+{
+  return std::array<uint64_t (*)(T), sizeof...(I)> {&consume<I, T>...};
+}
+
+using sequence = std::make_integer_sequence<int, FOOTPRINT_COMBINATIONS>;
+}  // namespace
+
+// Taking every consumer's address keeps all of them, and their producers, in the object file
+extern const auto footprint_int64 = consumers<int64_t>(sequence {});
+extern const auto footprint_uint64 = consumers<uint64_t>(sequence {});
+extern const auto footprint_double = consumers<double>(sequence {});
+extern const auto footprint_pointer = consumers<const int64_t*>(sequence {});
@@ -0,0 +1,190 @@
+#pragma once
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>  // for std::strerror
+#include <string>
+
+#if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+/**
+ * @brief Hardware counters of the calling thread around a piece of code, through perf_event_open
+ *
+ * Each event is opened on its own, so a CPU or VM without, say, L1D miss counting still reports the rest. Counts are
+ * scaled by enabled/running time when the kernel multiplexes them. Where perf events are not permitted
+ * (perf_event_paranoid, containers, other OSes) nothing opens and available() is false.
+ */
+class perf_counters
+{
+public:
+  static constexpr size_t event_count = 5;
+
+  static constexpr std::array<const char*, event_count> names = {
+      "cycles", "instructions", "branches", "branch-misses", "L1D-misses"};
+
+  struct sample
+  {
+    std::array<double, event_count> counts {};
+    std::array<bool, event_count>   valid {};
+  };
+
+private:
+  std::array<int, event_count> fds;
+  std::string                  failure;
+
+#if defined(__linux__)
+  static int open_event(uint32_t type, uint64_t config)
+  {
+    perf_event_attr attr {};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+  }
+#endif
+
+public:
+  perf_counters()
+  {
+    fds.fill(-1);
+#if defined(__linux__)
+    const uint64_t l1d_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (static_cast<uint64_t>(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+    fds[0] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[1] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[2] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+    fds[3] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[4] = open_event(PERF_TYPE_HW_CACHE, l1d_miss);
+    if (!available()) {
+      failure = std::string("perf_event_open: ") + std::strerror(errno);
+    }
+#else
+    failure = "perf events are only supported on Linux";
+#endif
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  ~perf_counters()
+  {
+#if defined(__linux__)
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+#endif
+  }
+
+  [[nodiscard]] bool available() const noexcept
+  {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Why nothing could be opened
+  [[nodiscard]] const std::string& error() const noexcept { return failure; }
+
+  void start() noexcept
+  {
+#if defined(__linux__)
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  sample stop() noexcept
+  {
+    sample result;
+#if defined(__linux__)
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+    for (size_t i = 0; i < event_count; ++i) {
+      uint64_t values[3] = {};  // Count, time enabled, time running
+      if (fds[i] < 0 || ::read(fds[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))
+          || values[2] == 0)
+      {
+        continue;
+      }
+      const double scale = static_cast<double>(values[1]) / static_cast<double>(values[2]);
+      result.counts[i] = static_cast<double>(values[0]) * scale;
+      result.valid[i] = true;
+    }
+#endif
+    return result;
+  }
+};
+
+// The counters shared by all reports, nullptr with a note on the first call when none could be opened
+inline perf_counters* shared_perf_counters()
+{
+  static perf_counters counters;
+  static bool          warned = false;
+  if (counters.available()) {
+    return &counters;
+  }
+  if (!warned) {
+    std::printf("\n  (no hardware counters, %s)\n", counters.error().c_str());
+    std::fflush(stdout);
+    warned = true;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Runs body iterations times between start() and stop() and prints the counters per iteration
+ *
+ * This is a run of its own after the benchmark, so the counters describe these iterations, not the timed samples.
+ * The line is indented so it sits under the benchmark's row in the Catch2 console output and is not mistaken for a
+ * result by scripts/parse_catch2_benchmarks.py.
+ */
+template<typename F>
+void report_perf_counters(const std::string& name, F&& body, int iterations = 1000)
+{
+  perf_counters* counters = shared_perf_counters();
+  if (counters == nullptr) {
+    return;
+  }
+
+  body();  // Warm up caches and predictors like the benchmark itself did
+  counters->start();
+  for (int i = 0; i < iterations; ++i) {
+    auto result = body();
+    asm volatile("" : : "r,m"(result) : "memory");
+  }
+  const perf_counters::sample counts = counters->stop();
+
+  std::printf("\n  %s, per iteration:", name.c_str());
+  for (size_t i = 0; i < perf_counters::event_count; ++i) {
+    if (counts.valid[i]) {
+      std::printf(" %.1f %s", counts.counts[i] / iterations, perf_counters::names[i]);
+    }
+  }
+  if (counts.valid[0] && counts.valid[1] && counts.counts[0] > 0) {
+    std::printf(", IPC %.2f", counts.counts[1] / counts.counts[0]);
+  }
+  std::printf("\n");
+  std::fflush(stdout);
+}
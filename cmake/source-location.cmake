@@ -0,0 +1,12 @@
+# Sets EXPECTED64_HAS_SOURCE_LOCATION when the standard library provides
+# <source_location>, which EXPECTED64_ERROR_COUNTERS and EXPECTED64_ERROR_TRACE
+# need. libc++ only has it from version 16.
+
+include(CheckCXXSourceCompiles)
+include(CMakePushCheckState)
+
+cmake_push_check_state()
+set(CMAKE_REQUIRED_FLAGS "${CMAKE_CXX20_STANDARD_COMPILE_OPTION}")
+check_cxx_source_compiles("#include <source_location>
+int main() { return static_cast<int>(std::source_location::current().line()); }" EXPECTED64_HAS_SOURCE_LOCATION)
+cmake_pop_check_state()
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>  // std::memcpy
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief Branch-free kernels over arrays of raw expected64 words
+ *
+ * Each call looks at up to 64 words and returns a bitmask with bit i set when word i matches. With GCC and Clang the
+ * words are tested two at a time in 128-bit vectors, using expected64::error_msb() on the whole vector and a sign-bit
+ * movemask on x86, other compilers get the equivalent scalar loop.
+ */
+
+// Words per cache line, the natural batch for probing tables
+inline constexpr size_t batch_width = 64 / sizeof(uint64_t);
+
+namespace expected64_detail
+{
+#if defined(__GNUC__)
+#  define EXPECTED64_BATCH_VECTOR 1
+typedef uint64_t batch_vector __attribute__((vector_size(16)));
+
+inline batch_vector load_batch_vector(const uint64_t* words) noexcept
+{
+  batch_vector v;
+  std::memcpy(&v, words, sizeof(v));
+  return v;
+}
+
+// Two-bit mask of the lane MSBs
+inline uint64_t msb_mask(batch_vector v) noexcept
+{
+#  if defined(__SSE2__)
+  return static_cast<uint64_t>(_mm_movemask_pd(reinterpret_cast<__m128d>(v)));
+#  else
+  return (v[0] >> 63) | ((v[1] >> 63) << 1);
+#  endif
+}
+#endif
+}  // namespace expected64_detail
+
+// Bit i is set when words[i] is an error of Result, count must be at most 64
+template<typename Result>
+[[nodiscard]] inline uint64_t batch_error_mask(const uint64_t* words, size_t count) noexcept
+{
+  uint64_t mask = 0;
+  size_t   i = 0;
+#if defined(EXPECTED64_BATCH_VECTOR)
+  using expected64_detail::batch_vector;
+  for (; i + 2 <= count; i += 2) {
+    const batch_vector v = expected64_detail::load_batch_vector(words + i);
+    mask |= expected64_detail::msb_mask(Result::error_msb(v)) << i;
+  }
+#endif
+  for (; i < count; ++i) {
+    mask |= (Result::error_msb(words[i]) >> 63) << i;
+  }
+  return mask;
+}
+
+// Bit i is set when words[i] == needle, count must be at most 64
+[[nodiscard]] inline uint64_t batch_equal_mask(const uint64_t* words, size_t count, uint64_t needle) noexcept
+{
+  uint64_t mask = 0;
+  size_t   i = 0;
+#if defined(EXPECTED64_BATCH_VECTOR)
+  using expected64_detail::batch_vector;
+  for (; i + 2 <= count; i += 2) {
+    const auto equal = reinterpret_cast<batch_vector>(expected64_detail::load_batch_vector(words + i) == needle);
+    mask |= expected64_detail::msb_mask(equal) << i;
+  }
+#endif
+  for (; i < count; ++i) {
+    mask |= static_cast<uint64_t>(words[i] == needle) << i;
+  }
+  return mask;
+}
@@ -0,0 +1,745 @@
+#pragma once
+#include <array>
+#include <bit>  // std::bit_cast, std::popcount
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>  // std::getenv
+#include <cstring>  // std::memcpy, std::strcmp
+#include <type_traits>
+
+#include "expected64/batch.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#  define EXPECTED64_BATCH_X86 1
+#  include <immintrin.h>
+#endif
+
+#if defined(EXPECTED64_BATCH_STD_SIMD)
+#  if !__has_include(<experimental/simd>)
+#    error "EXPECTED64_BATCH_STD_SIMD needs <experimental/simd>"
+#  endif
+#  include <experimental/simd>
+#endif
+
+/**
+ * @brief Span kernels over raw expected64 words, with an implementation per instruction set picked at run time
+ *
+ * The first call selects the widest backend the CPU and OS support, from CPUID, and keeps it for the life of the
+ * process. Compiled with EXPECTED64_BATCH_STD_SIMD, the portable std::experimental::simd backend, at the native width
+ * of the compiler flags, is selected instead. EXPECTED64_BATCH_BACKEND=scalar|avx2|avx512|simd in the environment
+ * selects a backend explicitly, as long as it is supported. batch_kernels(backend) returns any backend's entry points,
+ * so tests can check each against scalar.
+ * All backends produce identical results, including the double sums of batch_sum(), which add into eight fixed lanes.
+ */
+
+enum class batch_backend
+{
+  scalar,
+  avx2,
+  avx512,
+  simd  // std::experimental::simd, with EXPECTED64_BATCH_STD_SIMD
+};
+
+[[nodiscard]] inline const char* batch_backend_name(batch_backend backend) noexcept
+{
+  switch (backend) {
+    case batch_backend::avx2:
+      return "avx2";
+    case batch_backend::avx512:
+      return "avx512";
+    case batch_backend::simd:
+      return "simd";
+    default:
+      return "scalar";
+  }
+}
+
+[[nodiscard]] inline bool batch_backend_supported(batch_backend backend) noexcept
+{
+#if defined(EXPECTED64_BATCH_X86)
+  __builtin_cpu_init();  // Only needed before constructors run, but harmless later
+  if (backend == batch_backend::avx2) {
+    return __builtin_cpu_supports("avx2");
+  }
+  if (backend == batch_backend::avx512) {
+    return __builtin_cpu_supports("avx512f");
+  }
+#endif
+#if defined(EXPECTED64_BATCH_STD_SIMD)
+  if (backend == batch_backend::simd) {
+    return true;
+  }
+#endif
+  return backend == batch_backend::scalar;
+}
+
+/**
+ * @brief Entry points of one backend for one expected64 type
+ *
+ * sum is null for pointers. bits arrays hold one bit per word, bit i % 64 of bits[i / 64], and are written in full.
+ */
+template<typename Result>
+struct batch_kernel_table
+{
+  size_t (*error_bits)(const uint64_t* words, size_t count, uint64_t* bits) noexcept;
+  Result (*sum)(const uint64_t* words, size_t count) noexcept;
+  size_t (*compact)(const uint64_t* words, size_t count, uint64_t* out) noexcept;
+  size_t (*decode)(const uint64_t* words, size_t count, uint64_t* values, uint64_t* payloads, uint64_t* bits) noexcept;
+  void (*encode)(const uint64_t* values, const uint64_t* payloads, const uint64_t* bits, size_t count,
+                 uint64_t* words) noexcept;
+};
+
+namespace expected64_detail
+{
+// Lanes of the batch_sum() accumulator, the same for every backend so floating point sums match exactly
+inline constexpr size_t sum_lanes = 8;
+
+template<typename Result>
+using sum_type = std::conditional_t<std::is_same_v<typename Result::value_type, double>, double, uint64_t>;
+
+template<typename Result>
+sum_type<Result> sum_value(uint64_t word) noexcept
+{
+  if constexpr (std::is_same_v<typename Result::value_type, double>) {
+    return std::bit_cast<double>(word);
+  } else {
+    return word;  // Integers add modulo 2^64
+  }
+}
+
+template<typename Result>
+Result sum_result(const sum_type<Result>* lanes) noexcept
+{
+  sum_type<Result> total = lanes[0];
+  for (size_t lane = 1; lane < sum_lanes; ++lane) {
+    total += lanes[lane];
+  }
+  return Result(static_cast<typename Result::value_type>(total));
+}
+
+// Portable reference, one word at a time
+template<typename Result>
+struct scalar_kernels
+{
+  static size_t error_bits(const uint64_t* words, size_t count, uint64_t* bits) noexcept
+  {
+    size_t errors = 0;
+    for (size_t base = 0; base < count; base += 64) {
+      const size_t block = count - base < 64 ? count - base : 64;
+      uint64_t     mask = 0;
+      for (size_t i = 0; i < block; ++i) {
+        mask |= (Result::error_msb(words[base + i]) >> 63) << i;
+      }
+      bits[base / 64] = mask;
+      errors += static_cast<size_t>(std::popcount(mask));
+    }
+    return errors;
+  }
+
+  static Result sum(const uint64_t* words, size_t count) noexcept
+  {
+    sum_type<Result> lanes[sum_lanes] = {};
+    for (size_t i = 0; i < count; ++i) {
+      if (Result::error_msb(words[i]) != 0) {
+        return Result::from_bits(words[i]);
+      }
+      lanes[i % sum_lanes] += sum_value<Result>(words[i]);
+    }
+    return sum_result<Result>(lanes);
+  }
+
+  static size_t compact(const uint64_t* words, size_t count, uint64_t* out) noexcept
+  {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+      out[kept] = words[i];
+      kept += Result::error_msb(words[i]) == 0;
+    }
+    return kept;
+  }
+
+  static size_t decode(
+      const uint64_t* words, size_t count, uint64_t* values, uint64_t* payloads, uint64_t* bits) noexcept
+  {
+    for (size_t i = 0; i < count; ++i) {
+      const bool error = Result::error_msb(words[i]) != 0;
+      values[i] = error ? 0 : words[i];
+      payloads[i] = error ? Result::error_payload(words[i]) : 0;
+    }
+    return error_bits(words, count, bits);
+  }
+
+  static void encode(const uint64_t* values, const uint64_t* payloads, const uint64_t* bits, size_t count,
+                     uint64_t* words) noexcept
+  {
+    const uint64_t flags = Result::error_bits({});
+    for (size_t i = 0; i < count; ++i) {
+      words[i] = (bits[i / 64] >> (i % 64)) & 1 ? flags | payloads[i] : values[i];
+    }
+  }
+};
+
+#if defined(EXPECTED64_BATCH_X86)
+// Vector kernels shared by the x86 backends, always inlined into the target-specific entry points below. Only those and
+// the Lanes members take or return vectors by value: any other function doing so would be compiled without AVX and
+// pass the vectors differently, so the helpers here transform them in place.
+template<typename Lanes>
+using lane_vector = typename Lanes::vector;
+
+// Result::error_msb(), for whole vectors
+template<typename Result, typename Vector>
+[[gnu::always_inline]] inline void to_error_msb(Vector& bits) noexcept
+{
+  using T = typename Result::value_type;
+  constexpr uint64_t msb = static_cast<uint64_t>(1) << 63;
+  if constexpr (std::is_same_v<typename Result::policy_type, tagged_nan_policy>) {
+    constexpr uint64_t tag = tagged_nan_policy::error_tag;
+    constexpr uint64_t tag_unit = static_cast<uint64_t>(1) << 48;
+    const Vector       untagged = bits ^ tag;
+    bits = (untagged - tag_unit) & ~untagged & msb;
+  } else if constexpr (std::is_same_v<T, double>) {
+    constexpr uint64_t mantissa = 0x000F'FFFF'FFFF'FFFF;
+    bits = ((bits & ~msb) + mantissa) & msb;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    bits = (bits ^ (bits << 1)) & msb;
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    bits &= msb;
+  } else {
+    bits <<= 63;
+  }
+}
+
+// Result::error_payload(), for whole vectors
+template<typename Result, typename Vector>
+[[gnu::always_inline]] inline void to_error_payload(Vector& bits) noexcept
+{
+  using T = typename Result::value_type;
+  if constexpr (std::is_same_v<typename Result::policy_type, tagged_nan_policy>) {
+    bits &= 0x0000'FFFF'FFFF'FFFF;
+  } else if constexpr (std::is_same_v<T, double>) {
+    bits &= ~0xFFF8'0000'0000'0000;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    const Vector negative = static_cast<uint64_t>(0) - (bits >> 63);
+    bits &= ~(((static_cast<uint64_t>(1) << 62) & ~negative) | (1 & negative));
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    bits &= ~(static_cast<uint64_t>(1) << 63);
+  } else {
+    bits &= ~static_cast<uint64_t>(1);
+  }
+}
+
+// All ones in the lanes that hold an error, zero elsewhere
+template<typename Result, typename Vector>
+[[gnu::always_inline]] inline void to_error_lanes(Vector& bits) noexcept
+{
+  to_error_msb<Result>(bits);
+  bits = static_cast<uint64_t>(0) - (bits >> 63);
+}
+
+template<typename Lanes, typename Result>
+[[gnu::always_inline]] inline uint64_t error_mask_of(const uint64_t* words) noexcept
+{
+  lane_vector<Lanes> v;
+  std::memcpy(&v, words, sizeof(v));
+  to_error_msb<Result>(v);
+  return Lanes::msb_mask(v);
+}
+
+template<typename Lanes, typename Result>
+[[gnu::always_inline]] inline size_t vector_error_bits(const uint64_t* words, size_t count, uint64_t* bits) noexcept
+{
+  size_t errors = 0;
+  for (size_t base = 0; base < count; base += 64) {
+    const size_t block = count - base < 64 ? count - base : 64;
+    uint64_t     mask = 0;
+    size_t       i = 0;
+    for (; i + Lanes::width <= block; i += Lanes::width) {
+      mask |= error_mask_of<Lanes, Result>(words + base + i) << i;
+    }
+    for (; i < block; ++i) {
+      mask |= (Result::error_msb(words[base + i]) >> 63) << i;
+    }
+    bits[base / 64] = mask;
+    errors += static_cast<size_t>(std::popcount(mask));
+  }
+  return errors;
+}
+
+template<typename Lanes, typename Result>
+[[gnu::always_inline]] inline Result vector_sum(const uint64_t* words, size_t count) noexcept
+{
+  using value_vector = std::conditional_t<std::is_same_v<typename Result::value_type, double>,
+                                          typename Lanes::double_vector,
+                                          lane_vector<Lanes>>;
+  constexpr size_t vectors = sum_lanes / Lanes::width;
+
+  value_vector acc[vectors] = {};
+  size_t       i = 0;
+  for (; i + sum_lanes <= count; i += sum_lanes) {
+    lane_vector<Lanes> v[vectors];
+    lane_vector<Lanes> any_error {};
+    for (size_t k = 0; k < vectors; ++k) {
+      std::memcpy(&v[k], words + i + k * Lanes::width, sizeof(v[k]));
+      lane_vector<Lanes> error = v[k];
+      to_error_msb<Result>(error);
+      any_error |= error;
+    }
+    if (Lanes::msb_mask(any_error) != 0) {
+      break;  // The scalar loop below finds the error
+    }
+    for (size_t k = 0; k < vectors; ++k) {
+      acc[k] += reinterpret_cast<value_vector>(v[k]);
+    }
+  }
+
+  sum_type<Result> lanes[sum_lanes];
+  std::memcpy(lanes, acc, sizeof(lanes));
+  for (; i < count; ++i) {
+    if (Result::error_msb(words[i]) != 0) {
+      return Result::from_bits(words[i]);
+    }
+    lanes[i % sum_lanes] += sum_value<Result>(words[i]);
+  }
+  return sum_result<Result>(lanes);
+}
+
+template<typename Lanes, typename Result>
+[[gnu::always_inline]] inline size_t vector_compact(const uint64_t* words, size_t count, uint64_t* out) noexcept
+{
+  constexpr uint64_t all_lanes = (static_cast<uint64_t>(1) << Lanes::width) - 1;
+
+  size_t kept = 0;
+  size_t i = 0;
+  for (; i + Lanes::width <= count; i += Lanes::width) {
+    const uint64_t valid = ~error_mask_of<Lanes, Result>(words + i) & all_lanes;
+    // Writes a whole vector, which stays inside out[0, count) because kept <= i
+    Lanes::compress_store(out + kept, words + i, valid);
+    kept += static_cast<size_t>(std::popcount(valid));
+  }
+  for (; i < count; ++i) {
+    out[kept] = words[i];
+    kept += Result::error_msb(words[i]) == 0;
+  }
+  return kept;
+}
+
+template<typename Lanes, typename Result>
+[[gnu::always_inline]] inline size_t vector_decode(
+    const uint64_t* words, size_t count, uint64_t* values, uint64_t* payloads, uint64_t* bits) noexcept
+{
+  size_t i = 0;
+  for (; i + Lanes::width <= count; i += Lanes::width) {
+    lane_vector<Lanes> v;
+    std::memcpy(&v, words + i, sizeof(v));
+    lane_vector<Lanes> error = v;
+    to_error_lanes<Result>(error);
+    lane_vector<Lanes> payload = v;
+    to_error_payload<Result>(payload);
+    v &= ~error;
+    payload &= error;
+    std::memcpy(values + i, &v, sizeof(v));
+    std::memcpy(payloads + i, &payload, sizeof(payload));
+  }
+  for (; i < count; ++i) {
+    const bool error = Result::error_msb(words[i]) != 0;
+    values[i] = error ? 0 : words[i];
+    payloads[i] = error ? Result::error_payload(words[i]) : 0;
+  }
+  return vector_error_bits<Lanes, Result>(words, count, bits);
+}
+
+template<typename Lanes, typename Result>
+[[gnu::always_inline]] inline void vector_encode(
+    const uint64_t* values, const uint64_t* payloads, const uint64_t* bits, size_t count, uint64_t* words) noexcept
+{
+  const uint64_t flags = Result::error_bits({});
+  size_t         i = 0;
+  for (; i + Lanes::width <= count; i += Lanes::width) {
+    // Lanes::width divides 64, so a vector never straddles two bits words
+    lane_vector<Lanes> error = lane_vector<Lanes> {} + (bits[i / 64] >> (i % 64));
+    error = static_cast<uint64_t>(0) - ((error >> Lanes::lane_index) & 1);
+    lane_vector<Lanes> value;
+    lane_vector<Lanes> payload;
+    std::memcpy(&value, values + i, sizeof(value));
+    std::memcpy(&payload, payloads + i, sizeof(payload));
+    value = (value & ~error) | ((payload | flags) & error);
+    std::memcpy(words + i, &value, sizeof(value));
+  }
+  for (; i < count; ++i) {
+    words[i] = (bits[i / 64] >> (i % 64)) & 1 ? flags | payloads[i] : values[i];
+  }
+}
+
+#  define EXPECTED64_BATCH_ENTRY_POINTS(isa, Lanes)                                                                   \
+    template<typename Result>                                                                                         \
+    struct Lanes##_kernels                                                                                            \
+    {                                                                                                                 \
+      [[gnu::target(isa)]] static size_t error_bits(const uint64_t* words, size_t count, uint64_t* bits) noexcept     \
+      {                                                                                                               \
+        return vector_error_bits<Lanes, Result>(words, count, bits);                                                  \
+      }                                                                                                               \
+      [[gnu::target(isa)]] static Result sum(const uint64_t* words, size_t count) noexcept                            \
+      {                                                                                                               \
+        return vector_sum<Lanes, Result>(words, count);                                                               \
+      }                                                                                                               \
+      [[gnu::target(isa)]] static size_t compact(const uint64_t* words, size_t count, uint64_t* out) noexcept         \
+      {                                                                                                               \
+        return vector_compact<Lanes, Result>(words, count, out);                                                      \
+      }                                                                                                               \
+      [[gnu::target(isa)]] static size_t decode(                                                                      \
+          const uint64_t* words, size_t count, uint64_t* values, uint64_t* payloads, uint64_t* bits) noexcept         \
+      {                                                                                                               \
+        return vector_decode<Lanes, Result>(words, count, values, payloads, bits);                                    \
+      }                                                                                                               \
+      [[gnu::target(isa)]] static void encode(                                                                        \
+          const uint64_t* values, const uint64_t* payloads, const uint64_t* bits, size_t count, uint64_t* words)      \
+          noexcept                                                                                                    \
+      {                                                                                                               \
+        vector_encode<Lanes, Result>(values, payloads, bits, count, words);                                           \
+      }                                                                                                               \
+    };
+
+struct avx2_lanes
+{
+  static constexpr size_t width = 4;
+  typedef uint64_t        vector __attribute__((vector_size(32)));
+  typedef double          double_vector __attribute__((vector_size(32)));
+
+  static constexpr vector lane_index = {0, 1, 2, 3};
+
+  [[gnu::target("avx2")]] static uint64_t msb_mask(vector v) noexcept
+  {
+    return static_cast<uint64_t>(_mm256_movemask_pd(reinterpret_cast<__m256d>(v)));
+  }
+
+  // Byte k of compress_order[mask] is the 32-bit source half of output half k, for _mm256_permutevar8x32_epi32
+  static constexpr auto compress_order = []
+  {
+    std::array<uint64_t, 16> order {};
+    for (uint64_t mask = 0; mask < 16; ++mask) {
+      uint64_t half = 0;
+      for (uint64_t lane = 0; lane < 4; ++lane) {
+        if ((mask >> lane) & 1) {
+          order[mask] |= (lane * 2) << (half * 8) | (lane * 2 + 1) << (half * 8 + 8);
+          half += 2;
+        }
+      }
+    }
+    return order;
+  }();
+
+  // Moves the lanes selected by mask to the front
+  [[gnu::target("avx2")]] static void compress_store(uint64_t* out, const uint64_t* words, uint64_t mask) noexcept
+  {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+    const __m128i order = _mm_cvtsi64_si128(static_cast<long long>(compress_order[mask]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(v, _mm256_cvtepu8_epi32(order)));
+  }
+};
+
+struct avx512_lanes
+{
+  static constexpr size_t width = 8;
+  typedef uint64_t        vector __attribute__((vector_size(64)));
+  typedef double          double_vector __attribute__((vector_size(64)));
+
+  static constexpr vector lane_index = {0, 1, 2, 3, 4, 5, 6, 7};
+
+  [[gnu::target("avx512f")]] static uint64_t msb_mask(vector v) noexcept
+  {
+    const auto word = reinterpret_cast<__m512i>(v);
+    return _mm512_test_epi64_mask(word, _mm512_set1_epi64(INT64_MIN));
+  }
+
+  [[gnu::target("avx512f")]] static void compress_store(uint64_t* out, const uint64_t* words, uint64_t mask) noexcept
+  {
+    _mm512_storeu_si512(out, _mm512_maskz_compress_epi64(static_cast<__mmask8>(mask), _mm512_loadu_si512(words)));
+  }
+};
+
+EXPECTED64_BATCH_ENTRY_POINTS("avx2", avx2_lanes)
+EXPECTED64_BATCH_ENTRY_POINTS("avx512f", avx512_lanes)
+#  undef EXPECTED64_BATCH_ENTRY_POINTS
+#endif
+
+#if defined(EXPECTED64_BATCH_STD_SIMD)
+// The same kernels on std::experimental::simd, for any target the compiler vectorizes. The word tests are
+// Result::error_msb() and Result::error_payload() themselves, applied to whole simd objects.
+template<typename Result>
+struct std_simd_kernels
+{
+  using vector = std::experimental::native_simd<uint64_t>;
+  using double_vector = std::experimental::rebind_simd_t<double, vector>;
+
+  static constexpr size_t width = vector::size();
+  static_assert(sum_lanes % width == 0, "The sum lanes must split into whole vectors");
+
+  static vector load(const uint64_t* words) noexcept { return vector(words, std::experimental::element_aligned); }
+
+  static uint64_t error_mask(vector v) noexcept
+  {
+    const vector msb = Result::error_msb(v);
+    uint64_t     mask = 0;
+    for (size_t lane = 0; lane < width; ++lane) {
+      mask |= (msb[lane] >> 63) << lane;
+    }
+    return mask;
+  }
+
+  // All ones in the lanes that hold an error, zero elsewhere
+  static vector error_lanes(vector v) noexcept { return static_cast<uint64_t>(0) - (Result::error_msb(v) >> 63); }
+
+  static size_t error_bits(const uint64_t* words, size_t count, uint64_t* bits) noexcept
+  {
+    size_t errors = 0;
+    for (size_t base = 0; base < count; base += 64) {
+      const size_t block = count - base < 64 ? count - base : 64;
+      uint64_t     mask = 0;
+      size_t       i = 0;
+      for (; i + width <= block; i += width) {
+        mask |= error_mask(load(words + base + i)) << i;
+      }
+      for (; i < block; ++i) {
+        mask |= (Result::error_msb(words[base + i]) >> 63) << i;
+      }
+      bits[base / 64] = mask;
+      errors += static_cast<size_t>(std::popcount(mask));
+    }
+    return errors;
+  }
+
+  static Result sum(const uint64_t* words, size_t count) noexcept
+  {
+    using value_vector =
+        std::conditional_t<std::is_same_v<typename Result::value_type, double>, double_vector, vector>;
+    constexpr size_t vectors = sum_lanes / width;
+
+    value_vector acc[vectors] = {};
+    size_t       i = 0;
+    for (; i + sum_lanes <= count; i += sum_lanes) {
+      vector v[vectors];
+      vector any_error = 0;
+      for (size_t k = 0; k < vectors; ++k) {
+        v[k] = load(words + i + k * width);
+        any_error |= Result::error_msb(v[k]);
+      }
+      if (std::experimental::any_of(any_error != 0)) {
+        break;  // The scalar loop below finds the error
+      }
+      for (size_t k = 0; k < vectors; ++k) {
+        acc[k] += std::bit_cast<value_vector>(v[k]);
+      }
+    }
+
+    sum_type<Result> lanes[sum_lanes];
+    for (size_t k = 0; k < vectors; ++k) {
+      acc[k].copy_to(lanes + k * width, std::experimental::element_aligned);
+    }
+    for (; i < count; ++i) {
+      if (Result::error_msb(words[i]) != 0) {
+        return Result::from_bits(words[i]);
+      }
+      lanes[i % sum_lanes] += sum_value<Result>(words[i]);
+    }
+    return sum_result<Result>(lanes);
+  }
+
+  // The simd TS has no compress, so vectors with errors are compacted a word at a time
+  static size_t compact(const uint64_t* words, size_t count, uint64_t* out) noexcept
+  {
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i + width <= count; i += width) {
+      const vector v = load(words + i);
+      if (error_mask(v) == 0) {
+        v.copy_to(out + kept, std::experimental::element_aligned);
+        kept += width;
+        continue;
+      }
+      for (size_t lane = 0; lane < width; ++lane) {
+        out[kept] = v[lane];
+        kept += Result::error_msb(static_cast<uint64_t>(v[lane])) == 0;
+      }
+    }
+    for (; i < count; ++i) {
+      out[kept] = words[i];
+      kept += Result::error_msb(words[i]) == 0;
+    }
+    return kept;
+  }
+
+  static size_t decode(
+      const uint64_t* words, size_t count, uint64_t* values, uint64_t* payloads, uint64_t* bits) noexcept
+  {
+    size_t i = 0;
+    for (; i + width <= count; i += width) {
+      const vector v = load(words + i);
+      const vector error = error_lanes(v);
+      (v & ~error).copy_to(values + i, std::experimental::element_aligned);
+      (Result::error_payload(v) & error).copy_to(payloads + i, std::experimental::element_aligned);
+    }
+    for (; i < count; ++i) {
+      const bool error = Result::error_msb(words[i]) != 0;
+      values[i] = error ? 0 : words[i];
+      payloads[i] = error ? Result::error_payload(words[i]) : 0;
+    }
+    return error_bits(words, count, bits);
+  }
+
+  static void encode(const uint64_t* values, const uint64_t* payloads, const uint64_t* bits, size_t count,
+                     uint64_t* words) noexcept
+  {
+    const uint64_t flags = Result::error_bits({});
+    const vector   lane_index([](auto lane) { return static_cast<uint64_t>(lane); });
+    size_t         i = 0;
+    for (; i + width <= count; i += width) {
+      // width divides 64, so a vector never straddles two bits words
+      const vector error = static_cast<uint64_t>(0) - ((vector(bits[i / 64] >> (i % 64)) >> lane_index) & 1);
+      const vector word = (load(values + i) & ~error) | ((load(payloads + i) | flags) & error);
+      word.copy_to(words + i, std::experimental::element_aligned);
+    }
+    for (; i < count; ++i) {
+      words[i] = (bits[i / 64] >> (i % 64)) & 1 ? flags | payloads[i] : values[i];
+    }
+  }
+};
+#endif
+
+template<template<typename> typename Kernels, typename Result>
+constexpr batch_kernel_table<Result> make_kernel_table() noexcept
+{
+  if constexpr (std::is_pointer_v<typename Result::value_type>) {
+    return {&Kernels<Result>::error_bits, nullptr, &Kernels<Result>::compact, &Kernels<Result>::decode,
+            &Kernels<Result>::encode};
+  } else {
+    return {&Kernels<Result>::error_bits, &Kernels<Result>::sum, &Kernels<Result>::compact, &Kernels<Result>::decode,
+            &Kernels<Result>::encode};
+  }
+}
+
+// The override when it names a supported backend, otherwise std::experimental::simd if compiled in, otherwise the
+// widest supported instruction set
+inline batch_backend select_batch_backend() noexcept
+{
+#if defined(EXPECTED64_BATCH_STD_SIMD)
+  constexpr batch_backend preferred[] = {batch_backend::simd, batch_backend::scalar};
+#else
+  constexpr batch_backend preferred[] = {batch_backend::avx512, batch_backend::avx2, batch_backend::scalar};
+#endif
+  if (const char* name = std::getenv("EXPECTED64_BATCH_BACKEND")) {
+    for (const batch_backend backend :
+         {batch_backend::scalar, batch_backend::avx2, batch_backend::avx512, batch_backend::simd}) {
+      if (std::strcmp(name, batch_backend_name(backend)) == 0 && batch_backend_supported(backend)) {
+        return backend;
+      }
+    }
+  }
+  for (const batch_backend backend : preferred) {
+    if (batch_backend_supported(backend)) {
+      return backend;
+    }
+  }
+  return batch_backend::scalar;
+}
+}  // namespace expected64_detail
+
+// Backend used by the batch_* functions below, chosen on the first call
+[[nodiscard]] inline batch_backend active_batch_backend() noexcept
+{
+  static const batch_backend backend = expected64_detail::select_batch_backend();
+  return backend;
+}
+
+// Entry points of backend, which falls back to scalar when unsupported
+template<typename Result>
+[[nodiscard]] const batch_kernel_table<Result>& batch_kernels(batch_backend backend) noexcept
+{
+  using expected64_detail::make_kernel_table;
+  static constexpr auto scalar = make_kernel_table<expected64_detail::scalar_kernels, Result>();
+#if defined(EXPECTED64_BATCH_X86)
+  static constexpr auto avx2 = make_kernel_table<expected64_detail::avx2_lanes_kernels, Result>();
+  static constexpr auto avx512 = make_kernel_table<expected64_detail::avx512_lanes_kernels, Result>();
+  if (batch_backend_supported(backend)) {
+    if (backend == batch_backend::avx512) {
+      return avx512;
+    }
+    if (backend == batch_backend::avx2) {
+      return avx2;
+    }
+  }
+#endif
+#if defined(EXPECTED64_BATCH_STD_SIMD)
+  static constexpr auto simd = make_kernel_table<expected64_detail::std_simd_kernels, Result>();
+  if (backend == batch_backend::simd) {
+    return simd;
+  }
+#endif
+  static_cast<void>(backend);
+  return scalar;
+}
+
+namespace expected64_detail
+{
+template<typename Result>
+const batch_kernel_table<Result>& active_kernels() noexcept
+{
+  static const batch_kernel_table<Result>& kernels = batch_kernels<Result>(active_batch_backend());
+  return kernels;
+}
+}  // namespace expected64_detail
+
+/**
+ * @brief Sets bit i of bits when words[i] is an error of Result and returns the number of errors
+ *
+ * bits needs (count + 63) / 64 words.
+ */
+template<typename Result>
+size_t batch_error_bits(const uint64_t* words, size_t count, uint64_t* bits) noexcept
+{
+  return expected64_detail::active_kernels<Result>().error_bits(words, count, bits);
+}
+
+/**
+ * @brief Sum of the values, or the lowest-index error
+ *
+ * Integers wrap modulo 2^64, and a sum that leaves the range of Result is not detected. Doubles are added into eight
+ * lanes by index modulo 8, then the lanes in order, so results do not depend on the backend.
+ */
+template<typename Result>
+Result batch_sum(const uint64_t* words, size_t count) noexcept
+{
+  static_assert(!std::is_pointer_v<typename Result::value_type>, "batch_sum needs numbers");
+  return expected64_detail::active_kernels<Result>().sum(words, count);
+}
+
+/**
+ * @brief Copies the words that are not errors to out, in order, and returns how many there are
+ *
+ * out needs room for count words, all of which may be written.
+ */
+template<typename Result>
+size_t batch_compact(const uint64_t* words, size_t count, uint64_t* out) noexcept
+{
+  return expected64_detail::active_kernels<Result>().compact(words, count, out);
+}
+
+/**
+ * @brief Splits words into columns: values (0 for errors), error_payload() (0 for values) and error bits
+ *
+ * Returns the number of errors. bits needs (count + 63) / 64 words.
+ */
+template<typename Result>
+size_t batch_decode(const uint64_t* words, size_t count, uint64_t* values, uint64_t* payloads, uint64_t* bits) noexcept
+{
+  return expected64_detail::active_kernels<Result>().decode(words, count, values, payloads, bits);
+}
+
+/**
+ * @brief Inverse of batch_decode(): words[i] is the error with payloads[i] where bit i is set, values[i] otherwise
+ */
+template<typename Result>
+void batch_encode(const uint64_t* values, const uint64_t* payloads, const uint64_t* bits, size_t count,
+                  uint64_t* words) noexcept
+{
+  expected64_detail::active_kernels<Result>().encode(values, payloads, bits, count, words);
+}
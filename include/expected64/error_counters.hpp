@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>  // std::stable_sort, std::find_if
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>  // std::strcmp
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <vector>
+
+/**
+ * @brief Per call site, per error code counters behind EXPECTED64_ERROR_COUNTERS
+ *
+ * With the macro defined, expected64(E) and set_error() take a defaulted std::source_location and bump a counter in a
+ * table owned by the calling thread: a hash, a probe and an unshared increment, no locks and no atomic RMW. Without
+ * the macro none of this is compiled in. snapshot_error_counters() gathers the tables of all threads, including threads
+ * that have exited, and snapshots from several processes or runs can be combined with merge().
+ */
+
+struct error_count
+{
+  std::source_location location;
+  uint64_t             code = 0;
+  uint64_t             count = 0;
+};
+
+struct error_counters_snapshot
+{
+  std::vector<error_count> counts;  // Sorted by count, highest first
+  uint64_t                 dropped = 0;  // Errors not counted because a thread's table was full
+
+  void merge(const error_counters_snapshot& other);
+};
+
+namespace expected64_detail
+{
+// Same call site: pointers can differ between translation units, so compare the strings
+inline bool same_site(const error_count& a, const error_count& b) noexcept
+{
+  return a.code == b.code && a.location.line() == b.location.line() && a.location.column() == b.location.column()
+      && std::strcmp(a.location.file_name(), b.location.file_name()) == 0;
+}
+
+inline void sort_counts(std::vector<error_count>& counts)
+{
+  std::stable_sort(
+      counts.begin(), counts.end(), [](const error_count& a, const error_count& b) { return a.count > b.count; });
+}
+
+// Adds counts into into, entry by entry
+inline void add_counts(std::vector<error_count>& into, const std::vector<error_count>& counts)
+{
+  for (const error_count& entry : counts) {
+    auto it = std::find_if(into.begin(), into.end(), [&](const error_count& e) { return same_site(e, entry); });
+    if (it == into.end()) {
+      into.push_back(entry);
+    } else {
+      it->count += entry.count;
+    }
+  }
+}
+
+class error_site_table
+{
+public:
+  static constexpr size_t capacity = 1024;  // Distinct (call site, code) pairs per thread
+
+private:
+  struct slot
+  {
+    std::atomic<bool>     used {false};
+    std::source_location  location;  // Written once by the owning thread before used is set
+    uint64_t              code = 0;
+    std::atomic<uint64_t> count {0};
+  };
+
+  std::array<slot, capacity> slots;
+  std::atomic<uint64_t>      overflow {0};
+
+  // Only the owning thread writes, readers in snapshot_error_counters() just need untorn values
+  static void bump(std::atomic<uint64_t>& counter) noexcept
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+public:
+  void record(const std::source_location& location, uint64_t code) noexcept
+  {
+    uint64_t h = reinterpret_cast<uintptr_t>(location.file_name()) ^ (static_cast<uint64_t>(location.line()) << 16)
+        ^ location.column() ^ (code << 40);
+    h *= 0x9E37'79B9'7F4A'7C15;
+    for (size_t i = (h >> 32) % capacity, probes = 0; probes < capacity; i = (i + 1) % capacity, ++probes) {
+      slot& s = slots[i];
+      if (!s.used.load(std::memory_order_relaxed)) {
+        s.location = location;
+        s.code = code;
+        s.count.store(1, std::memory_order_relaxed);
+        s.used.store(true, std::memory_order_release);
+        return;
+      }
+      if (s.code == code && s.location.line() == location.line() && s.location.column() == location.column()
+          && s.location.file_name() == location.file_name())
+      {
+        bump(s.count);
+        return;
+      }
+    }
+    bump(overflow);
+  }
+
+  uint64_t total() const noexcept
+  {
+    uint64_t sum = overflow.load(std::memory_order_relaxed);
+    for (const slot& s : slots) {
+      sum += s.used.load(std::memory_order_acquire) ? s.count.load(std::memory_order_relaxed) : 0;
+    }
+    return sum;
+  }
+
+  void collect(error_counters_snapshot& into) const
+  {
+    std::vector<error_count> counts;
+    for (const slot& s : slots) {
+      if (s.used.load(std::memory_order_acquire)) {
+        counts.push_back(error_count {s.location, s.code, s.count.load(std::memory_order_relaxed)});
+      }
+    }
+    add_counts(into.counts, counts);
+    into.dropped += overflow.load(std::memory_order_relaxed);
+  }
+};
+
+class error_counter_registry
+{
+  std::mutex                     mutex;
+  std::vector<error_site_table*> live;
+  error_counters_snapshot        retired;  // Counts of threads that have exited
+
+public:
+  static error_counter_registry& instance()
+  {
+    static error_counter_registry registry;
+    return registry;
+  }
+
+  void add(error_site_table* table)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    live.push_back(table);
+  }
+
+  void retire(error_site_table* table) noexcept
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+      table->collect(retired);
+    } catch (...) {
+      retired.dropped += table->total();  // No memory for its entries, keep at least the number of errors
+    }
+    live.erase(std::find(live.begin(), live.end(), table));
+  }
+
+  error_counters_snapshot snapshot()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    error_counters_snapshot     result = retired;
+    for (const error_site_table* table : live) {
+      table->collect(result);
+    }
+    return result;
+  }
+};
+
+// The calling thread's table, allocated on its first error and folded into the registry when the thread exits.
+// Creating an error is noexcept, so a thread whose table can't be allocated or registered counts nothing.
+class thread_error_table
+{
+  std::unique_ptr<error_site_table> table;
+
+public:
+  thread_error_table() noexcept
+  {
+    try {
+      table = std::make_unique<error_site_table>();
+      error_counter_registry::instance().add(table.get());
+    } catch (...) {
+      table.reset();
+    }
+  }
+
+  thread_error_table(const thread_error_table&) = delete;
+  thread_error_table& operator=(const thread_error_table&) = delete;
+
+  ~thread_error_table()
+  {
+    if (table) {
+      error_counter_registry::instance().retire(table.get());
+    }
+  }
+
+  error_site_table* get() const noexcept { return table.get(); }
+};
+
+inline void count_error(const std::source_location& location, uint64_t code) noexcept
+{
+  static thread_local thread_error_table table;
+  if (error_site_table* t = table.get()) {
+    t->record(location, code);
+  }
+}
+}  // namespace expected64_detail
+
+inline void error_counters_snapshot::merge(const error_counters_snapshot& other)
+{
+  expected64_detail::add_counts(counts, other.counts);
+  dropped += other.dropped;
+  expected64_detail::sort_counts(counts);
+}
+
+// Counts of every thread so far
+[[nodiscard]] inline error_counters_snapshot snapshot_error_counters()
+{
+  error_counters_snapshot result = expected64_detail::error_counter_registry::instance().snapshot();
+  expected64_detail::sort_counts(result.counts);
+  return result;
+}
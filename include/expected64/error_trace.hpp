@@ -0,0 +1,202 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>  // std::nothrow
+#include <optional>
+#include <source_location>
+
+#if !defined(EXPECTED64_ERROR_TRACE_FRAMES)
+#  define EXPECTED64_ERROR_TRACE_FRAMES 0
+#endif
+#if EXPECTED64_ERROR_TRACE_FRAMES > 0
+#  include <execinfo.h>  // backtrace
+#endif
+
+/**
+ * @brief Error origins behind EXPECTED64_ERROR_TRACE
+ *
+ * With the macro defined, expected64(E) and set_error() record the caller's std::source_location, and with
+ * EXPECTED64_ERROR_TRACE_FRAMES > 0 that many return addresses, in a ring owned by the calling thread. The entry's
+ * 16-bit index goes into bits 32-47 of the error word, above any 32-bit error code, so the result stays 8 bytes and
+ * get_error() is unchanged. get_error_origin() reads the entry back from any thread.
+ *
+ * Rings are reused: after ring_size more errors on the same thread an origin is gone. The index has no bits left for a
+ * generation, so this is only detected when the newer error has a different code; otherwise its origin is returned.
+ * Index 0 means "not traced", e.g. errors built by from_bits() or when more than max_rings threads trace at the same
+ * time.
+ */
+
+struct error_origin
+{
+  std::source_location                                 location;
+  uint64_t                                             code = 0;
+  std::array<void*, EXPECTED64_ERROR_TRACE_FRAMES + 1> frames {};  // Return addresses, innermost first
+  size_t                                               frame_count = 0;
+};
+
+namespace expected64_detail
+{
+class trace_ring
+{
+public:
+  static constexpr uint32_t ring_bits = 10;
+  static constexpr uint32_t ring_size = 1U << ring_bits;
+  static constexpr uint32_t max_rings = 62;  // Indices stay below 0xFC00, clear of the reserved() codes
+
+private:
+  struct entry
+  {
+    std::atomic<uint64_t>                                             sequence {0};  // Odd while being rewritten
+    std::atomic<std::source_location>                                 location {};
+    std::atomic<uint64_t>                                             code {0};
+    std::array<std::atomic<void*>, EXPECTED64_ERROR_TRACE_FRAMES + 1> frames {};
+    std::atomic<size_t>                                               frame_count {0};
+  };
+
+  std::array<entry, ring_size> entries;
+  uint32_t                     next = 0;  // Only touched by the owning thread
+
+public:
+  uint32_t record(const std::source_location& location, uint64_t code) noexcept
+  {
+    const uint32_t slot = next++ % ring_size;
+    entry&         e = entries[slot];
+    const uint64_t sequence = e.sequence.load(std::memory_order_relaxed);
+    e.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.location.store(location, std::memory_order_relaxed);
+    e.code.store(code, std::memory_order_relaxed);
+#if EXPECTED64_ERROR_TRACE_FRAMES > 0
+    std::array<void*, EXPECTED64_ERROR_TRACE_FRAMES> buffer {};
+    const int depth = ::backtrace(buffer.data(), EXPECTED64_ERROR_TRACE_FRAMES);
+    for (int i = 0; i < depth; ++i) {
+      e.frames[static_cast<size_t>(i)].store(buffer[static_cast<size_t>(i)], std::memory_order_relaxed);
+    }
+    e.frame_count.store(depth > 0 ? static_cast<size_t>(depth) : 0, std::memory_order_relaxed);
+#endif
+    e.sequence.store(sequence + 2, std::memory_order_release);
+    return slot;
+  }
+
+  std::optional<error_origin> read(uint32_t slot, uint64_t code) const noexcept
+  {
+    const entry& e = entries[slot];
+    for (int attempt = 0; attempt < 16; ++attempt) {
+      const uint64_t before = e.sequence.load(std::memory_order_acquire);
+      if ((before & 1) != 0) {
+        continue;
+      }
+      error_origin origin;
+      origin.location = e.location.load(std::memory_order_relaxed);
+      origin.code = e.code.load(std::memory_order_relaxed);
+      origin.frame_count = e.frame_count.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < origin.frame_count; ++i) {
+        origin.frames[i] = e.frames[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (e.sequence.load(std::memory_order_relaxed) != before) {
+        continue;
+      }
+      if (before == 0 || origin.code != code) {
+        return std::nullopt;  // Never written, or reused by a later error with another code
+      }
+      return origin;
+    }
+    return std::nullopt;
+  }
+};
+
+// Rings are handed to threads while they run and kept for the life of the process, so any thread can read them
+class trace_registry
+{
+  std::mutex                                                  mutex;
+  std::array<std::atomic<trace_ring*>, trace_ring::max_rings> rings {};
+  std::array<bool, trace_ring::max_rings>                     in_use {};
+
+public:
+  static trace_registry& instance()
+  {
+    static trace_registry registry;
+    return registry;
+  }
+
+  // Ring number in [1, max_rings], 0 when all are taken
+  uint32_t acquire() noexcept
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint32_t i = 0; i < trace_ring::max_rings; ++i) {
+      if (!in_use[i]) {
+        if (rings[i].load(std::memory_order_relaxed) == nullptr) {
+          trace_ring* ring = new (std::nothrow) trace_ring;
+          if (ring == nullptr) {
+            return 0;
+          }
+          rings[i].store(ring, std::memory_order_release);
+        }
+        in_use[i] = true;
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+  void release(uint32_t number) noexcept
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    in_use[number - 1] = false;
+  }
+
+  trace_ring* ring(uint32_t number) const noexcept { return rings[number - 1].load(std::memory_order_acquire); }
+};
+
+class thread_trace_ring
+{
+  uint32_t number;
+
+public:
+  thread_trace_ring()
+      : number(trace_registry::instance().acquire())
+  {
+  }
+
+  thread_trace_ring(const thread_trace_ring&) = delete;
+  thread_trace_ring& operator=(const thread_trace_ring&) = delete;
+
+  ~thread_trace_ring()
+  {
+    if (number != 0) {
+      trace_registry::instance().release(number);
+    }
+  }
+
+  [[nodiscard]] uint32_t get() const noexcept { return number; }
+};
+
+// Records an error and returns its 16-bit trace index, 0 if it could not be traced
+inline uint64_t trace_error(const std::source_location& location, uint64_t code) noexcept
+{
+  static thread_local thread_trace_ring ring;
+  const uint32_t                        number = ring.get();
+  if (number == 0) {
+    return 0;
+  }
+  const uint32_t slot = trace_registry::instance().ring(number)->record(location, code);
+  return (static_cast<uint64_t>(number) << trace_ring::ring_bits) | slot;
+}
+
+inline std::optional<error_origin> find_error_origin(uint64_t index, uint64_t code) noexcept
+{
+  const auto number = static_cast<uint32_t>(index >> trace_ring::ring_bits);
+  if (number == 0 || number > trace_ring::max_rings) {
+    return std::nullopt;
+  }
+  const trace_ring* ring = trace_registry::instance().ring(number);
+  if (ring == nullptr) {
+    return std::nullopt;
+  }
+  return ring->read(static_cast<uint32_t>(index & (trace_ring::ring_size - 1)), code);
+}
+}  // namespace expected64_detail
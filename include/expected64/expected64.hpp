@@ -1,8 +1,39 @@
 #pragma once
+#include <bit>  // std::bit_cast
+#include <cassert>
 #include <cmath>  // std::isnan
 #include <cstdint>
 #include <limits>  // std::numeric_limits
 #include <string>
+
+#if defined(EXPECTED64_ERROR_COUNTERS) || defined(EXPECTED64_ERROR_TRACE)
+#  include <source_location>
+// Creating an error records the caller's source location
+#  define EXPECTED64_ERROR_SITE , std::source_location error_site = std::source_location::current()
+#  define EXPECTED64_PASS_ERROR_SITE , error_site
+#else
+#  define EXPECTED64_ERROR_SITE
+#  define EXPECTED64_PASS_ERROR_SITE
+#endif
+
+#if defined(EXPECTED64_ERROR_COUNTERS)
+#  include "expected64/error_counters.hpp"
+#  define EXPECTED64_COUNT_ERROR(code) expected64_detail::count_error(error_site, static_cast<uint64_t>(code))
+#else
+#  define EXPECTED64_COUNT_ERROR(code)
+#endif
+
+#if defined(EXPECTED64_ERROR_TRACE)
+#  include <optional>
+#  include "expected64/error_trace.hpp"
+// The trace index goes into bits 32-47 of the error word
+#  define EXPECTED64_TRACE_ERROR(code) \
+    value = std::bit_cast<T>( \
+        to_bits() | (expected64_detail::trace_error(error_site, static_cast<uint64_t>(code)) << 32))
+#else
+#  define EXPECTED64_TRACE_ERROR(code)
+#endif
+
 /**
  * @brief Tagged union for 64-bit expected value
  */
@@ -11,13 +42,36 @@ template<typename T>
 concept Expected64Type =
     std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> || std::is_same_v<T, double> || std::is_pointer_v<T>;
 
-template<Expected64Type T, typename E>
+// Doubles: every NaN is an error, the default
+struct any_nan_policy
+{
+};
+
+/**
+ * @brief Doubles: only NaNs whose top 16 bits are error_tag are errors, every other NaN is a value
+ *
+ * error_tag is a positive quiet NaN with payload bits 48-50 set, which neither arithmetic nor std::numeric_limits
+ * produce, so NaNs in the data (missing values, 0.0 / 0.0) stay values. Errors keep the code in bits 0-31 and the trace
+ * index in bits 32-47, as with any_nan_policy.
+ */
+struct tagged_nan_policy
+{
+  static constexpr uint64_t error_tag = 0x7FFF'0000'0000'0000;
+};
+
+template<Expected64Type T, typename E, typename Policy = any_nan_policy>
 class expected64
 {
   static_assert(sizeof(T) == 8, "T should be 64-bit");
   static_assert(sizeof(E) < sizeof(T), "E should be smaller than T");
   static_assert(std::is_trivially_destructible<T>::value, "T must be trivially destructible");
   static_assert(std::is_trivially_destructible<E>::value, "E must be trivially destructible");
+#if defined(EXPECTED64_ERROR_TRACE)
+  static_assert(sizeof(E) <= 4, "Error tracing needs bits 32-47 of the error word");
+#endif
+  static_assert(std::is_same_v<Policy, any_nan_policy>
+                    || (std::is_same_v<Policy, tagged_nan_policy> && std::is_same_v<T, double>),
+                "tagged_nan_policy applies to doubles only");
 
   union
   {
@@ -29,18 +83,26 @@ class expected64
   static constexpr uint64_t uint64_error_flag = static_cast<uint64_t>(1) << 63;  // MSB as error flag for uint64_t
   static constexpr uint64_t ptr_error_flag = 1;  // LSB as error flag for pointers
   static constexpr uint64_t nan_mask = 0xFFF8'0000'0000'0000;  // Create a quiet NaN and preserve space for error code
+  static constexpr bool     tagged_nans = std::is_same_v<Policy, tagged_nan_policy>;
 public:
+  using value_type = T;
+  using error_type = E;
+  using policy_type = Policy;
+
   expected64(T val) noexcept
       : value(val)
   {
   }
 
-  expected64(E error_value) noexcept { set_error(error_value); }
+  expected64(E error_value EXPECTED64_ERROR_SITE) noexcept { set_error(error_value EXPECTED64_PASS_ERROR_SITE); }
 
-  void set_error(E error_value)
+  void set_error(E error_value EXPECTED64_ERROR_SITE)
   {
+    EXPECTED64_COUNT_ERROR(error_value);
     error = error_value;
-    if constexpr (std::is_same_v<T, double>) {
+    if constexpr (tagged_nans) {
+      value = std::bit_cast<T>(tagged_nan_policy::error_tag | static_cast<uint64_t>(error_value));
+    } else if constexpr (std::is_same_v<T, double>) {
       double   nan_val = std::numeric_limits<double>::quiet_NaN();
       uint64_t nan_bits = *reinterpret_cast<const uint64_t*>(&nan_val);
       nan_bits = (nan_bits & nan_mask) | static_cast<uint64_t>(error_value);
@@ -55,19 +117,18 @@ public:
         reinterpret_cast<uint64_t&>(value) |= ptr_error_flag;
       }
     }
+    EXPECTED64_TRACE_ERROR(error_value);
   }
 
   [[nodiscard]] inline bool has_error() const noexcept
   {
-    if constexpr (std::is_same_v<T, double>) {
+    if constexpr (tagged_nans) {
+      return (to_bits() >> 48) == (tagged_nan_policy::error_tag >> 48);
+    } else if constexpr (std::is_same_v<T, double>) {
       return std::isnan(value);
     } else if constexpr (std::is_same_v<T, int64_t>) {
-      uint64_t raw_bits = reinterpret_cast<const uint64_t&>(value);
-      bool     isNegative = (raw_bits & (static_cast<uint64_t>(1) << 63)) != 0;
-      bool     isErrorBitSet = (raw_bits & int64_error_flag) != 0;
-
-      // For negative values, error if MSB+1 is NOT set (0), else no error if set (1)
-      return isNegative ? !isErrorBitSet : isErrorBitSet;
+      // Error iff bit 62 differs from the sign bit, without the branch a sign test would compile to
+      return error_msb(reinterpret_cast<const uint64_t&>(value)) != 0;
     } else if constexpr (std::is_same_v<T, uint64_t> || std::is_pointer_v<T>) {
       uint64_t error_flag = std::is_same_v<T, uint64_t> ? uint64_error_flag : ptr_error_flag;
       return (reinterpret_cast<const uint64_t&>(value) & error_flag) != 0;
@@ -76,21 +137,113 @@ public:
 
   [[nodiscard]] inline T get_value() const noexcept { return value; }
 
-  [[nodiscard]] inline E get_error() const noexcept
+  [[nodiscard]] inline uint64_t to_bits() const noexcept { return std::bit_cast<uint64_t>(value); }
+
+  [[nodiscard]] static inline expected64 from_bits(uint64_t bits) noexcept
+  {
+    return expected64(std::bit_cast<T>(bits));
+  }
+
+  /**
+   * @brief The word set_error() stores for error_value, without counting it under EXPECTED64_ERROR_COUNTERS
+   */
+  [[nodiscard]] static constexpr uint64_t error_bits(E error_value) noexcept
   {
-    if constexpr (std::is_same_v<T, double>) {
-      uint64_t error_code_bits = reinterpret_cast<const uint64_t&>(value) & ~nan_mask;
-      return static_cast<E>(error_code_bits);
+    const auto code = static_cast<uint64_t>(error_value);
+    if constexpr (tagged_nans) {
+      return tagged_nan_policy::error_tag | code;
+    } else if constexpr (std::is_same_v<T, double>) {
+      return 0x7FF8'0000'0000'0000 | code;  // Quiet NaN
     } else if constexpr (std::is_same_v<T, int64_t>) {
-      if (value >= 0) {  // Positive int64
-        return static_cast<E>(reinterpret_cast<const uint64_t&>(value) & ~int64_error_flag);
-      } else {  // Negative int64
-        return static_cast<E>(reinterpret_cast<const uint64_t&>(value) & ~ptr_error_flag);
-      }
+      return code | int64_error_flag;
     } else if constexpr (std::is_same_v<T, uint64_t>) {
-      return static_cast<E>(reinterpret_cast<const uint64_t&>(value) & ~uint64_error_flag);
+      return code | uint64_error_flag;
     } else if constexpr (std::is_pointer_v<T>) {
-      return static_cast<E>(reinterpret_cast<const uintptr_t&>(value) & ~ptr_error_flag);
+      return code | ptr_error_flag;
+    }
+  }
+
+  /**
+   * @brief Error word carrying code (0xFFFF - k) << 32, which no E of up to 32 bits can produce
+   *
+   * set_error() never creates these words, so containers can use them to mark empty or deleted slots without any
+   * extra metadata bytes. k must be below 16.
+   */
+  [[nodiscard]] static inline expected64 reserved(uint32_t k) noexcept
+  {
+    static_assert(sizeof(E) <= 4, "Reserved codes live above 32-bit error codes");
+    assert(k < 16 && "reserved words have 16 codes");
+    return from_bits(error_bits(E {}) | (static_cast<uint64_t>(0xFFFF - k) << 32));
+  }
+
+  /**
+   * @brief Branch-free form of has_error() on a raw word: bit 63 is set for errors and every other bit is clear
+   *
+   * OR-ing these over many words answers "is any of them an error" with a single test. Word may also be a GCC/Clang
+   * vector of uint64_t, which tests every lane at once.
+   */
+  template<typename Word = uint64_t>
+  [[nodiscard]] static constexpr Word error_msb(Word bits) noexcept
+  {
+    constexpr uint64_t msb = static_cast<uint64_t>(1) << 63;
+    if constexpr (tagged_nans) {
+      // The top 16 bits are the tag iff XOR-ing it leaves a word below 2^48, which then borrows into bit 63 below
+      constexpr uint64_t tag = tagged_nan_policy::error_tag;
+      constexpr uint64_t tag_unit = static_cast<uint64_t>(1) << 48;
+      const Word         untagged = bits ^ tag;
+      return (untagged - tag_unit) & ~untagged & msb;
+    } else if constexpr (std::is_same_v<T, double>) {
+      // NaN iff the magnitude bits exceed infinity's, i.e. adding the mantissa mask carries into bit 63
+      constexpr uint64_t mantissa = 0x000F'FFFF'FFFF'FFFF;
+      return ((bits & ~msb) + mantissa) & msb;
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      return (bits ^ (bits << 1)) & msb;  // Error iff bit 62 differs from the sign bit
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+      return bits & uint64_error_flag;
+    } else if constexpr (std::is_pointer_v<T>) {
+      return bits << 63;
+    }
+  }
+
+  /**
+   * @brief get_error() on a raw word before the cast to E: the error word with its flag bits cleared
+   *
+   * Like error_msb(), Word may be a GCC/Clang vector of uint64_t.
+   */
+  template<typename Word = uint64_t>
+  [[nodiscard]] static constexpr Word error_payload(Word bits) noexcept
+  {
+    if constexpr (tagged_nans) {
+      constexpr uint64_t payload_mask = 0x0000'FFFF'FFFF'FFFF;
+      return bits & payload_mask;
+    } else if constexpr (std::is_same_v<T, double>) {
+      return bits & ~nan_mask;
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      // Clears bit 62 of non-negative words and the LSB of negative ones, the mask selected by the sign
+      const Word negative = static_cast<uint64_t>(0) - (bits >> 63);
+      return bits & ~((int64_error_flag & ~negative) | (ptr_error_flag & negative));
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+      return bits & ~uint64_error_flag;
+    } else if constexpr (std::is_pointer_v<T>) {
+      return bits & ~ptr_error_flag;
+    }
+  }
+
+  [[nodiscard]] inline E get_error() const noexcept { return static_cast<E>(error_payload(to_bits())); }
+
+#if defined(EXPECTED64_ERROR_TRACE)
+  /**
+   * @brief Where this error was created, empty if it was not traced or its ring entry was reused by an error with
+   * another code
+   *
+   * After trace_ring::ring_size more errors on the creating thread, a newer error with the same code may be returned.
+   */
+  [[nodiscard]] std::optional<error_origin> get_error_origin() const noexcept
+  {
+    if (!has_error()) {
+      return std::nullopt;
     }
+    return expected64_detail::find_error_origin((to_bits() >> 32) & 0xFFFF, static_cast<uint64_t>(get_error()));
   }
+#endif
 };
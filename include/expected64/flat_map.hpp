@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>  // std::max
+#include <array>
+#include <bit>  // std::bit_ceil, std::countr_zero
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "expected64/batch.hpp"
+#include "expected64/expected64.hpp"
+#include "expected64/optional64.hpp"
+
+/**
+ * @brief Open-addressing hash map from 64-bit integer keys to expected64 value types, 16 bytes per slot
+ *
+ * There are no control bytes and no sentinel keys: empty and deleted slots hold expected64::reserved() error words in
+ * the value array. Slots come in groups of eight stored as a key array next to a value array, so a probe finds the free
+ * slots of a whole group with batch_error_mask() on one cache line and compares its eight keys at once.
+ *
+ * Only values that expected64<T, E> can represent are accepted, i.e. no NaN doubles and no uint64_t with the MSB set.
+ */
+template<typename K, Expected64Type T>
+class expected64_flat_map
+{
+  static_assert(std::is_integral_v<K> && sizeof(K) == 8, "Keys must be 64-bit integers");
+
+public:
+  using key_type = K;
+  using mapped_type = T;
+
+private:
+  enum class slot_state : uint32_t
+  {
+  };
+  using word_type = expected64<T, slot_state>;
+
+  static constexpr size_t   group_size = batch_width;
+  static constexpr uint64_t all_lanes = (static_cast<uint64_t>(1) << group_size) - 1;
+
+  // Keys and values of a group sit on adjacent cache lines, which the hardware prefetches as a pair
+  struct alignas(128) group
+  {
+    std::array<uint64_t, group_size> keys;
+    std::array<uint64_t, group_size> values;
+  };
+
+  std::unique_ptr<group[]> groups;
+  size_t                   group_mask = 0;
+  size_t                   live = 0;
+  size_t                   used = 0;  // Live plus deleted slots, only a rehash reclaims the deleted ones
+
+  static uint64_t empty_word() noexcept { return word_type::reserved(0).to_bits(); }
+  static uint64_t deleted_word() noexcept { return word_type::reserved(1).to_bits(); }
+
+  static uint64_t mix(uint64_t h) noexcept
+  {
+    h ^= h >> 30;
+    h *= 0xBF58'476D'1CE4'E5B9;
+    h ^= h >> 27;
+    h *= 0x94D0'49BB'1331'11EB;
+    return h ^ (h >> 31);
+  }
+
+  // At most 7/8 of the slots may be used, so every probe sequence reaches an empty slot
+  static size_t groups_for(size_t count) noexcept
+  {
+    return std::bit_ceil(std::max<size_t>((count * 8 / 7 + group_size - 1) / group_size, 1));
+  }
+
+  void allocate(size_t group_count)
+  {
+    groups.reset(new group[group_count]);
+    group_mask = group_count - 1;
+    live = 0;
+    used = 0;
+    const uint64_t empty = empty_word();
+    for (size_t g = 0; g < group_count; ++g) {
+      groups[g].keys.fill(0);
+      groups[g].values.fill(empty);
+    }
+  }
+
+  // Value word of key, or nullptr
+  uint64_t* locate(K key) const noexcept
+  {
+    const auto     bits = static_cast<uint64_t>(key);
+    const uint64_t empty = empty_word();
+    for (size_t g = mix(bits) & group_mask, probes = 0; probes <= group_mask; g = (g + 1) & group_mask, ++probes) {
+      uint64_t*      words = groups[g].values.data();
+      const uint64_t free = batch_error_mask<word_type>(words, group_size);
+      const uint64_t hits = batch_equal_mask(groups[g].keys.data(), group_size, bits) & ~free;
+      if (hits != 0) {
+        return &words[std::countr_zero(hits)];
+      }
+      if (batch_equal_mask(words, group_size, empty) != 0) {
+        return nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  // Stores into the first free slot of key's probe sequence, the key must not be present
+  void place(uint64_t key_bits, uint64_t word) noexcept
+  {
+    const uint64_t empty = empty_word();
+    for (size_t g = mix(key_bits) & group_mask;; g = (g + 1) & group_mask) {
+      uint64_t*      words = groups[g].values.data();
+      const uint64_t free = batch_error_mask<word_type>(words, group_size);
+      if (free != 0) {
+        const auto lane = static_cast<size_t>(std::countr_zero(free));
+        used += words[lane] == empty;
+        ++live;
+        groups[g].keys[lane] = key_bits;
+        words[lane] = word;
+        return;
+      }
+    }
+  }
+
+  void rehash(size_t group_count)
+  {
+    std::unique_ptr<group[]> old = std::move(groups);
+    const size_t             old_groups = group_mask + 1;
+    allocate(group_count);
+    for (size_t g = 0; g < old_groups; ++g) {
+      uint64_t live_lanes = ~batch_error_mask<word_type>(old[g].values.data(), group_size) & all_lanes;
+      for (; live_lanes != 0; live_lanes &= live_lanes - 1) {
+        const auto lane = static_cast<size_t>(std::countr_zero(live_lanes));
+        place(old[g].keys[lane], old[g].values[lane]);
+      }
+    }
+  }
+
+public:
+  explicit expected64_flat_map(size_t capacity = 0) { allocate(groups_for(capacity)); }
+
+  expected64_flat_map(const expected64_flat_map&) = delete;
+  expected64_flat_map& operator=(const expected64_flat_map&) = delete;
+  // A moved-from map may only be destroyed or assigned to
+  expected64_flat_map(expected64_flat_map&&) noexcept = default;
+  expected64_flat_map& operator=(expected64_flat_map&&) noexcept = default;
+
+  [[nodiscard]] optional64<T> find(K key) const noexcept
+  {
+    if (const uint64_t* word = locate(key)) {
+      return optional64<T>(word_type::from_bits(*word).get_value());
+    }
+    return optional64<T>();
+  }
+
+  [[nodiscard]] bool contains(K key) const noexcept { return locate(key) != nullptr; }
+
+  /**
+   * @brief Inserts or overwrites key, returns false if value falls into the error encoding and can't be stored
+   */
+  bool insert_or_assign(K key, T value)
+  {
+    const word_type result(value);
+    if (result.has_error()) {
+      return false;
+    }
+    if (uint64_t* word = locate(key)) {
+      *word = result.to_bits();
+      return true;
+    }
+    if ((used + 1) * 8 > capacity() * 7) {
+      // Grow when mostly live, otherwise rebuild at the same size to drop the deleted slots
+      rehash(live + 1 > capacity() / 2 ? (group_mask + 1) * 2 : group_mask + 1);
+    }
+    place(static_cast<uint64_t>(key), result.to_bits());
+    return true;
+  }
+
+  bool erase(K key) noexcept
+  {
+    uint64_t* word = locate(key);
+    if (word == nullptr) {
+      return false;
+    }
+    *word = deleted_word();
+    --live;
+    return true;
+  }
+
+  void reserve(size_t count)
+  {
+    if (groups_for(count) > group_mask + 1) {
+      rehash(groups_for(count));
+    }
+  }
+
+  void clear() noexcept
+  {
+    const uint64_t empty = empty_word();
+    for (size_t g = 0; g <= group_mask; ++g) {
+      groups[g].values.fill(empty);
+    }
+    live = 0;
+    used = 0;
+  }
+
+  // Calls f(key, value) for every entry, in slot order
+  template<typename F>
+  void for_each(F&& f) const
+  {
+    for (size_t g = 0; g <= group_mask; ++g) {
+      const group& current = groups[g];
+      uint64_t     live_lanes = ~batch_error_mask<word_type>(current.values.data(), group_size) & all_lanes;
+      for (; live_lanes != 0; live_lanes &= live_lanes - 1) {
+        const auto lane = static_cast<size_t>(std::countr_zero(live_lanes));
+        f(static_cast<K>(current.keys[lane]), word_type::from_bits(current.values[lane]).get_value());
+      }
+    }
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return live; }
+  [[nodiscard]] bool   empty() const noexcept { return live == 0; }
+  [[nodiscard]] size_t capacity() const noexcept { return (group_mask + 1) * group_size; }
+};
@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>  // std::max, std::min
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief io_uring completions as expected64 results
+ *
+ * A CQE's res is a byte count (or other non-negative count) on success and -errno on failure, so it maps onto
+ * expected64<int64_t, std::errc> without reading errno: counts stay as they are and -errno becomes the error word
+ * set_error(std::errc(errno)) would store. Linux only, on the raw system calls rather than liburing.
+ */
+
+using io_result = expected64<int64_t, std::errc>;
+
+// The result for a CQE's res, branch-free unless error counters or traces need to see each error
+[[nodiscard]] inline io_result cqe_result(int32_t res EXPECTED64_ERROR_SITE) noexcept
+{
+#if defined(EXPECTED64_ERROR_COUNTERS) || defined(EXPECTED64_ERROR_TRACE)
+  return res < 0 ? io_result(static_cast<std::errc>(-res) EXPECTED64_PASS_ERROR_SITE) : io_result(int64_t {res});
+#else
+  const auto     count = static_cast<uint64_t>(static_cast<int64_t>(res));
+  const uint64_t negative = 0 - (count >> 63);
+  return io_result::from_bits((count & ~negative) | ((io_result::error_bits(std::errc {}) | (0 - count)) & negative));
+#endif
+}
+
+struct io_completion
+{
+  uint64_t  user_data = 0;
+  io_result result = io_result(int64_t {0});
+};
+
+// Converts a batch of CQEs, out must have room for cqes.size() completions
+inline void cqe_results(std::span<const io_uring_cqe> cqes, io_completion* out) noexcept
+{
+  for (const io_uring_cqe& cqe : cqes) {
+    *out++ = io_completion {cqe.user_data, cqe_result(cqe.res)};
+  }
+}
+
+/**
+ * @brief A single-threaded submission and completion ring
+ *
+ * prepare_read() and prepare_write() queue SQEs, submit() hands them to the kernel, optionally waiting for
+ * completions, and reap() converts whatever has completed into io_completion entries. Throws std::system_error if the
+ * ring can't be created, e.g. with ENOSYS on kernels without io_uring or EPERM where it is disabled.
+ */
+class io_uring_queue
+{
+  int           ring_fd = -1;
+  void*         sq_ring = nullptr;
+  void*         cq_ring = nullptr;
+  size_t        sq_ring_bytes = 0;
+  size_t        cq_ring_bytes = 0;
+  io_uring_sqe* sqes = nullptr;
+  size_t        sqes_bytes = 0;
+
+  unsigned*     sq_tail = nullptr;
+  unsigned      sq_mask = 0;
+  unsigned      sq_entries = 0;
+  unsigned*     sq_head = nullptr;
+  unsigned*     sq_array = nullptr;
+  unsigned*     cq_head = nullptr;
+  unsigned*     cq_tail = nullptr;
+  unsigned      cq_mask = 0;
+  io_uring_cqe* cqes = nullptr;
+  unsigned      unsubmitted = 0;
+
+  [[noreturn]] static void fail(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+  static void* map(int fd, size_t bytes, off_t offset) noexcept
+  {
+    void* addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return addr == MAP_FAILED ? nullptr : addr;
+  }
+
+  static unsigned* field(void* ring, uint32_t offset) noexcept
+  {
+    return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+  }
+
+  void unmap() noexcept
+  {
+    if (sqes != nullptr) {
+      ::munmap(sqes, sqes_bytes);
+    }
+    if (cq_ring != nullptr && cq_ring != sq_ring) {
+      ::munmap(cq_ring, cq_ring_bytes);
+    }
+    if (sq_ring != nullptr) {
+      ::munmap(sq_ring, sq_ring_bytes);
+    }
+    ::close(ring_fd);
+  }
+
+  bool prepare_rw(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t offset, uint64_t user_data) noexcept
+  {
+    const unsigned tail = *sq_tail;
+    if (tail - std::atomic_ref<unsigned>(*sq_head).load(std::memory_order_acquire) >= sq_entries) {
+      return false;
+    }
+    io_uring_sqe* sqe = &sqes[tail & sq_mask];
+    *sqe = io_uring_sqe {};
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = addr;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array[tail & sq_mask] = tail & sq_mask;
+    std::atomic_ref<unsigned>(*sq_tail).store(tail + 1, std::memory_order_release);  // Publishes the filled SQE
+    ++unsubmitted;
+    return true;
+  }
+
+public:
+  explicit io_uring_queue(unsigned entries)
+  {
+    io_uring_params params {};
+    ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0) {
+      fail("io_uring_queue: io_uring_setup");
+    }
+
+    sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_bytes = cq_ring_bytes = std::max(sq_ring_bytes, cq_ring_bytes);
+    }
+    sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+
+    sq_ring = map(ring_fd, sq_ring_bytes, IORING_OFF_SQ_RING);
+    cq_ring = single_mmap ? sq_ring : map(ring_fd, cq_ring_bytes, IORING_OFF_CQ_RING);
+    sqes = static_cast<io_uring_sqe*>(map(ring_fd, sqes_bytes, IORING_OFF_SQES));
+    if (sq_ring == nullptr || cq_ring == nullptr || sqes == nullptr) {
+      const int error = errno;
+      unmap();
+      errno = error;
+      fail("io_uring_queue: mmap");
+    }
+
+    sq_head = field(sq_ring, params.sq_off.head);
+    sq_tail = field(sq_ring, params.sq_off.tail);
+    sq_mask = *field(sq_ring, params.sq_off.ring_mask);
+    sq_entries = params.sq_entries;
+    sq_array = field(sq_ring, params.sq_off.array);
+    cq_head = field(cq_ring, params.cq_off.head);
+    cq_tail = field(cq_ring, params.cq_off.tail);
+    cq_mask = *field(cq_ring, params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cq_ring) + params.cq_off.cqes);
+  }
+
+  io_uring_queue(const io_uring_queue&) = delete;
+  io_uring_queue& operator=(const io_uring_queue&) = delete;
+
+  ~io_uring_queue() { unmap(); }
+
+  // Queues a read of len bytes at offset into buf, returns false when the submission queue is full
+  bool prepare_read(int fd, void* buf, uint32_t len, uint64_t offset, uint64_t user_data) noexcept
+  {
+    return prepare_rw(IORING_OP_READ, fd, reinterpret_cast<uint64_t>(buf), len, offset, user_data);
+  }
+
+  // Queues a write of len bytes from buf at offset, returns false when the submission queue is full
+  bool prepare_write(int fd, const void* buf, uint32_t len, uint64_t offset, uint64_t user_data) noexcept
+  {
+    return prepare_rw(IORING_OP_WRITE, fd, reinterpret_cast<uint64_t>(buf), len, offset, user_data);
+  }
+
+  /**
+   * @brief Submits the queued SQEs and waits until at least wait_for completions are ready
+   *
+   * Returns the number of SQEs the kernel consumed, or the error io_uring_enter failed with.
+   */
+  io_result submit(unsigned wait_for = 0) noexcept
+  {
+    const unsigned flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0;
+    const long     consumed = ::syscall(__NR_io_uring_enter, ring_fd, unsubmitted, wait_for, flags, nullptr, 0);
+    if (consumed < 0) {
+      return io_result(static_cast<std::errc>(errno));
+    }
+    unsubmitted -= static_cast<unsigned>(consumed);
+    return io_result(int64_t {consumed});
+  }
+
+  // Moves up to out.size() completions into out, returns how many
+  size_t reap(std::span<io_completion> out) noexcept
+  {
+    const unsigned head = *cq_head;
+    const unsigned ready = std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire) - head;
+    const size_t   count = std::min<size_t>(ready, out.size());
+    const unsigned first = head & cq_mask;
+    const size_t   contiguous = std::min<size_t>(count, cq_mask + 1 - first);
+    cqe_results(std::span<const io_uring_cqe>(cqes + first, contiguous), out.data());
+    cqe_results(std::span<const io_uring_cqe>(cqes, count - contiguous), out.data() + contiguous);
+    std::atomic_ref<unsigned>(*cq_head).store(head + static_cast<unsigned>(count), std::memory_order_release);
+    return count;
+  }
+
+  // SQEs prepared but not yet consumed by the kernel
+  [[nodiscard]] unsigned pending() const noexcept { return unsubmitted; }
+
+  [[nodiscard]] unsigned capacity() const noexcept { return sq_entries; }
+};
@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>  // std::max
+#include <array>
+#include <atomic>
+#include <bit>  // std::bit_ceil
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>  // std::memcpy
+#include <functional>  // std::hash
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "expected64/expected64.hpp"
+
+struct memo_cache_stats
+{
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t inserts = 0;
+  uint64_t evictions = 0;  // Inserts that replaced a live entry for another key
+  uint64_t expired = 0;  // Misses where the key was present but its error had outlived the TTL
+};
+
+template<typename Key, typename Result, size_t Ways = 4>
+class memo_cache;
+
+/**
+ * @brief Fixed-size, set-associative memoization cache for pure functions returning expected64
+ *
+ * Each slot is a key and the 8-byte result word guarded by a per-slot sequence counter. Readers never block: a read
+ * that races with a writer is reported as a miss. Writers claim a slot with one CAS on its sequence and give up if
+ * another writer holds it, which is harmless for a cache. Errors are cached too and can be given a time-to-live.
+ */
+template<typename Key, Expected64Type T, typename E, typename P, size_t Ways>
+class memo_cache<Key, expected64<T, E, P>, Ways>
+{
+  static_assert(sizeof(Key) <= 8, "Key must fit in 64 bits");
+  static_assert(std::is_trivially_copyable<Key>::value, "Key must be trivially copyable");
+  static_assert(Ways > 0, "Need at least one way");
+
+public:
+  using key_type = Key;
+  using result_type = expected64<T, E, P>;
+
+private:
+  struct slot
+  {
+    std::atomic<uint64_t> sequence {0};  // Odd while a writer owns the slot, 0 until first written
+    std::atomic<uint64_t> key {0};
+    std::atomic<uint64_t> word {0};
+    std::atomic<int64_t>  expires {0};  // steady_clock nanoseconds, 0 = never
+  };
+
+  struct alignas(64) set
+  {
+    std::array<slot, Ways> ways;
+  };
+
+  struct alignas(64) counter_stripe
+  {
+    std::atomic<uint64_t> hits {0};
+    std::atomic<uint64_t> misses {0};
+    std::atomic<uint64_t> inserts {0};
+    std::atomic<uint64_t> evictions {0};
+    std::atomic<uint64_t> expired {0};
+  };
+
+  static constexpr size_t stripe_count = 16;
+
+  std::unique_ptr<set[]>                   sets;
+  size_t                                   set_mask;
+  int64_t                                  error_ttl_ns;
+  std::array<counter_stripe, stripe_count> stripes;
+
+  static uint64_t key_bits(Key key) noexcept
+  {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &key, sizeof(Key));
+    return bits;
+  }
+
+  static uint64_t mix(uint64_t h) noexcept
+  {
+    // splitmix64 finaliser, std::hash is the identity for integers
+    h ^= h >> 30;
+    h *= 0xBF58'476D'1CE4'E5B9;
+    h ^= h >> 27;
+    h *= 0x94D0'49BB'1331'11EB;
+    return h ^ (h >> 31);
+  }
+
+  static int64_t now_ns() noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Threads get stripes round-robin, so up to stripe_count threads never share a counter line
+  counter_stripe& stripe() noexcept
+  {
+    static std::atomic<size_t>      next_stripe {0};
+    static thread_local const size_t index = next_stripe.fetch_add(1, std::memory_order_relaxed) % stripe_count;
+    return stripes[index];
+  }
+
+  // A load and a store instead of a locked add keeps lookups cheap. Threads sharing a stripe can lose the odd
+  // increment, so the counters are exact only up to stripe_count threads.
+  static void bump(std::atomic<uint64_t>& counter) noexcept
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+public:
+  /**
+   * @param capacity Minimum number of entries, rounded up to a power-of-two number of sets
+   * @param error_ttl How long cached errors stay valid, zero keeps them until evicted
+   */
+  explicit memo_cache(size_t capacity, std::chrono::nanoseconds error_ttl = std::chrono::nanoseconds::zero())
+      : sets(new set[std::bit_ceil(std::max<size_t>(capacity / Ways, 1))])
+      , set_mask(std::bit_ceil(std::max<size_t>(capacity / Ways, 1)) - 1)
+      , error_ttl_ns(error_ttl.count())
+  {
+  }
+
+  [[nodiscard]] size_t capacity() const noexcept { return (set_mask + 1) * Ways; }
+
+  [[nodiscard]] std::optional<result_type> find(Key key) noexcept
+  {
+    const uint64_t bits = key_bits(key);
+    set&           s = sets[mix(std::hash<Key>()(key)) & set_mask];
+    for (slot& way : s.ways) {
+      const uint64_t before = way.sequence.load(std::memory_order_acquire);
+      if (before == 0 || (before & 1) != 0) {
+        continue;
+      }
+      const uint64_t stored_key = way.key.load(std::memory_order_relaxed);
+      const uint64_t word = way.word.load(std::memory_order_relaxed);
+      const int64_t  expires = way.expires.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (way.sequence.load(std::memory_order_relaxed) != before || stored_key != bits) {
+        continue;
+      }
+      if (expires != 0 && expires <= now_ns()) {
+        bump(stripe().expired);
+        break;
+      }
+      bump(stripe().hits);
+      return result_type::from_bits(word);
+    }
+    bump(stripe().misses);
+    return std::nullopt;
+  }
+
+  void insert(Key key, result_type result) noexcept
+  {
+    const uint64_t bits = key_bits(key);
+    const uint64_t hash = mix(std::hash<Key>()(key));
+    set&           s = sets[hash & set_mask];
+
+    // Prefer the key's own slot, then a never used one, then a pseudo-random victim
+    slot* target = nullptr;
+    for (slot& way : s.ways) {
+      const uint64_t sequence = way.sequence.load(std::memory_order_relaxed);
+      if (sequence != 0 && way.key.load(std::memory_order_relaxed) == bits) {
+        target = &way;
+        break;
+      }
+      if (sequence == 0 && target == nullptr) {
+        target = &way;
+      }
+    }
+    const bool evicting = target == nullptr;
+    if (evicting) {
+      target = &s.ways[(hash >> 32) % Ways];
+    }
+
+    uint64_t sequence = target->sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) != 0
+        || !target->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+    {
+      return;  // Another writer owns the slot
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    int64_t expires = 0;
+    if (error_ttl_ns != 0 && result.has_error()) {
+      expires = now_ns() + error_ttl_ns;
+    }
+    target->key.store(bits, std::memory_order_relaxed);
+    target->word.store(result.to_bits(), std::memory_order_relaxed);
+    target->expires.store(expires, std::memory_order_relaxed);
+    target->sequence.store(sequence + 2, std::memory_order_release);
+
+    bump(stripe().inserts);
+    if (evicting) {
+      bump(stripe().evictions);
+    }
+  }
+
+  template<typename F>
+  result_type get_or_compute(Key key, F&& compute)
+  {
+    if (auto cached = find(key)) {
+      return *cached;
+    }
+    result_type result = compute(key);
+    insert(key, result);
+    return result;
+  }
+
+  [[nodiscard]] memo_cache_stats stats() const noexcept
+  {
+    memo_cache_stats total;
+    for (const counter_stripe& s : stripes) {
+      total.hits += s.hits.load(std::memory_order_relaxed);
+      total.misses += s.misses.load(std::memory_order_relaxed);
+      total.inserts += s.inserts.load(std::memory_order_relaxed);
+      total.evictions += s.evictions.load(std::memory_order_relaxed);
+      total.expired += s.expired.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <functional>  // std::equal_to
+#include <optional>  // std::nullopt_t, std::bad_optional_access
+#include <utility>  // std::swap
+
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief 8-byte optional that stores the empty state in the expected64 error encoding
+ *
+ * The absent state is simply an expected64 error, so the same niches apply: NaN for double, the MSB for uint64_t,
+ * bit 62 for int64_t and the LSB for pointers. Values that fall into those niches read back as empty.
+ */
+template<Expected64Type T>
+class optional64
+{
+  enum class empty_state : uint8_t
+  {
+    empty
+  };
+
+  expected64<T, empty_state> storage;
+
+  // Built from the raw word, so under EXPECTED64_ERROR_COUNTERS an empty optional64 is not counted as an error
+  static expected64<T, empty_state> empty_storage() noexcept
+  {
+    return expected64<T, empty_state>::from_bits(expected64<T, empty_state>::error_bits(empty_state::empty));
+  }
+
+public:
+  using value_type = T;
+
+  optional64() noexcept
+      : storage(empty_storage())
+  {
+  }
+
+  optional64(std::nullopt_t) noexcept
+      : optional64()
+  {
+  }
+
+  optional64(T val) noexcept
+      : storage(val)
+  {
+  }
+
+  // An expected64 error becomes an empty optional64, the error code is dropped
+  template<typename E, typename P>
+  explicit optional64(const expected64<T, E, P>& result) noexcept
+      : storage(result.has_error() ? empty_storage() : expected64<T, empty_state>(result.get_value()))
+  {
+  }
+
+  optional64& operator=(std::nullopt_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  [[nodiscard]] inline bool has_value() const noexcept { return !storage.has_error(); }
+
+  [[nodiscard]] explicit inline operator bool() const noexcept { return has_value(); }
+
+  [[nodiscard]] T value() const
+  {
+    if (!has_value()) {
+      throw std::bad_optional_access();
+    }
+    return storage.get_value();
+  }
+
+  // Unchecked access, like std::optional the caller must test has_value() first
+  [[nodiscard]] inline T operator*() const noexcept { return storage.get_value(); }
+
+  [[nodiscard]] inline T value_or(T default_value) const noexcept
+  {
+    return has_value() ? storage.get_value() : default_value;
+  }
+
+  T emplace(T val) noexcept
+  {
+    storage = expected64<T, empty_state>(val);
+    return val;
+  }
+
+  void reset() noexcept { storage = empty_storage(); }
+
+  void swap(optional64& other) noexcept { std::swap(storage, other.storage); }
+
+  template<typename E>
+  [[nodiscard]] expected64<T, E> to_expected(E error_value) const noexcept
+  {
+    return has_value() ? expected64<T, E>(storage.get_value()) : expected64<T, E>(error_value);
+  }
+
+  friend bool operator==(const optional64& lhs, const optional64& rhs) noexcept
+  {
+    if (lhs.has_value() != rhs.has_value()) {
+      return false;
+    }
+    return !lhs.has_value() || std::equal_to<T>()(*lhs, *rhs);
+  }
+
+  friend bool operator==(const optional64& lhs, std::nullopt_t) noexcept { return !lhs.has_value(); }
+
+  friend bool operator==(const optional64& lhs, T rhs) noexcept
+  {
+    return lhs.has_value() && std::equal_to<T>()(*lhs, rhs);
+  }
+};
+
+template<Expected64Type T>
+void swap(optional64<T>& lhs, optional64<T>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
@@ -0,0 +1,466 @@
+#pragma once
+#include <algorithm>  // std::min, std::max
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <ranges>  // std::ranges::data, std::ranges::size
+#include <thread>
+#include <type_traits>
+#include <utility>  // std::exchange
+#include <vector>
+
+#include "expected64/expected64.hpp"
+
+enum class error_policy
+{
+  run_all,  // Every element is computed, errors are written out like any other result
+  stop_on_first_error  // Chunks that have not started yet are skipped once any chunk saw an error
+};
+
+/**
+ * @brief Small work-stealing pool for chunked loops
+ *
+ * Every participant owns a contiguous range of chunk indices packed into one atomic word. Owners pop chunks from the
+ * front and idle participants steal the back half of someone else's range, so the common case costs one CAS per
+ * chunk. The calling thread takes part in every loop. Loops on the same executor are serialised and must not nest.
+ */
+class work_stealing_executor
+{
+  struct alignas(64) chunk_range
+  {
+    std::atomic<uint64_t> range {0};  // begin << 32 | end, in chunks
+  };
+
+  using chunk_fn = bool (*)(void* context, size_t chunk);
+
+  std::vector<std::thread>  workers;
+  std::vector<chunk_range>  ranges;
+  std::mutex                submit_mutex;  // One loop at a time
+  std::mutex                mutex;
+  std::condition_variable   wake;
+  std::condition_variable   done;
+  uint64_t                  generation = 0;
+  bool                      shutting_down = false;
+  std::atomic<unsigned>     active {0};
+  std::atomic<bool>         stop {false};
+  chunk_fn                  run_chunk = nullptr;
+  void*                     context = nullptr;
+  std::exception_ptr        failure;  // First exception thrown by a chunk, guarded by mutex
+
+  static constexpr uint64_t pack(uint64_t begin, uint64_t end) { return (begin << 32) | end; }
+  static constexpr uint64_t begin_of(uint64_t range) { return range >> 32; }
+  static constexpr uint64_t end_of(uint64_t range) { return range & 0xFFFF'FFFF; }
+
+  bool pop_front(unsigned self, size_t& chunk)
+  {
+    auto&    own = ranges[self].range;
+    uint64_t range = own.load(std::memory_order_acquire);
+    while (begin_of(range) < end_of(range)) {
+      if (own.compare_exchange_weak(range, pack(begin_of(range) + 1, end_of(range)), std::memory_order_acq_rel)) {
+        chunk = begin_of(range);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool steal(unsigned self, size_t& chunk)
+  {
+    const auto participants = static_cast<unsigned>(ranges.size());
+    for (unsigned offset = 1; offset < participants; ++offset) {
+      auto&    victim = ranges[(self + offset) % participants].range;
+      uint64_t range = victim.load(std::memory_order_acquire);
+      while (begin_of(range) < end_of(range)) {
+        uint64_t middle = begin_of(range) + (end_of(range) - begin_of(range)) / 2;
+        if (victim.compare_exchange_weak(range, pack(begin_of(range), middle), std::memory_order_acq_rel)) {
+          // Nobody steals from an empty range, so our own slot can be refilled with a plain store
+          ranges[self].range.store(pack(middle + 1, end_of(range)), std::memory_order_release);
+          chunk = middle;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void participate(unsigned self)
+  {
+    size_t chunk;
+    while (!stop.load(std::memory_order_relaxed) && (pop_front(self, chunk) || steal(self, chunk))) {
+      bool more = false;
+      try {
+        more = run_chunk(context, chunk);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure) {
+          failure = std::current_exception();
+        }
+      }
+      if (!more) {
+        stop.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void worker_loop(unsigned self)
+  {
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return shutting_down || generation != seen; });
+        if (shutting_down) {
+          return;
+        }
+        seen = generation;
+      }
+      participate(self);
+      if (active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.notify_one();
+      }
+    }
+  }
+
+public:
+  explicit work_stealing_executor(unsigned concurrency = std::thread::hardware_concurrency())
+      : ranges(std::max(concurrency, 1U))
+  {
+    workers.reserve(ranges.size() - 1);
+    for (unsigned i = 1; i < ranges.size(); ++i) {
+      workers.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  work_stealing_executor(const work_stealing_executor&) = delete;
+  work_stealing_executor& operator=(const work_stealing_executor&) = delete;
+
+  ~work_stealing_executor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      shutting_down = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  [[nodiscard]] unsigned concurrency() const noexcept { return static_cast<unsigned>(ranges.size()); }
+
+  /**
+   * @brief Calls body(chunk) for every chunk in [0, chunks), chunks must fit in 32 bits
+   *
+   * body returns false to stop handing out chunks; chunks already running still finish. The stop flag is read once
+   * per chunk. An exception from body, on any thread, stops the loop the same way and is rethrown here once every
+   * running chunk has finished; if several chunks throw, the first one caught wins.
+   */
+  template<typename Body>
+  void for_each_chunk(size_t chunks, Body&& body)
+  {
+    if (chunks == 0) {
+      return;
+    }
+    assert(chunks <= 0xFFFF'FFFF && "chunk indices are packed into 32 bits");
+    std::lock_guard<std::mutex> submit(submit_mutex);
+
+    run_chunk = [](void* ctx, size_t chunk) -> bool
+    { return (*static_cast<std::remove_reference_t<Body>*>(ctx))(chunk); };
+    context = &body;
+    stop.store(false, std::memory_order_relaxed);
+
+    const size_t participants = ranges.size();
+    for (size_t i = 0; i < participants; ++i) {
+      uint64_t begin = chunks * i / participants;
+      uint64_t end = chunks * (i + 1) / participants;
+      ranges[i].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+
+    if (!workers.empty()) {
+      active.store(static_cast<unsigned>(workers.size()), std::memory_order_relaxed);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+      }
+      wake.notify_all();
+    }
+
+    participate(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return active.load(std::memory_order_acquire) == 0; });
+    if (failure) {
+      std::rethrow_exception(std::exchange(failure, nullptr));
+    }
+  }
+};
+
+inline work_stealing_executor& default_executor()
+{
+  static work_stealing_executor executor;
+  return executor;
+}
+
+namespace expected64_detail
+{
+// Lowest-index error seen by any chunk. Only chunks that contain an error touch it.
+template<typename E>
+class first_error
+{
+  std::mutex mutex;
+  size_t     index;
+  E          error {};
+
+public:
+  explicit first_error(size_t none)
+      : index(none)
+  {
+  }
+
+  void offer(size_t at, E error_value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (at < index) {
+      index = at;
+      error = error_value;
+    }
+  }
+
+  [[nodiscard]] bool found(size_t none) const { return index != none; }
+  [[nodiscard]] E    get() const { return error; }
+};
+
+template<typename R>
+struct is_expected64 : std::false_type
+{
+};
+
+template<typename T, typename E, typename P>
+struct is_expected64<expected64<T, E, P>> : std::true_type
+{
+};
+
+// Enough chunks for stealing to balance uneven work without paying a CAS per handful of elements
+inline size_t default_grain(size_t n, unsigned concurrency)
+{
+  return std::max<size_t>(n / (static_cast<size_t>(concurrency) * 16), 1024);
+}
+
+// The requested grain, or the default for 0, raised as far as needed to keep the chunk count within 32 bits
+inline size_t chunk_grain(size_t n, size_t grain, unsigned concurrency)
+{
+  return std::max<size_t>(grain ? grain : default_grain(n, concurrency), (n >> 32) + 1);
+}
+
+inline size_t chunk_count(size_t n, size_t grain)
+{
+  return (n + grain - 1) / grain;
+}
+}  // namespace expected64_detail
+
+/**
+ * @brief out[i] = f(in[i]) for functions returning expected64
+ *
+ * Returns the number of elements when no error occurred, otherwise the error with the lowest index among the chunks
+ * that ran. With error_policy::stop_on_first_error, outputs of skipped chunks are left untouched.
+ */
+template<std::ranges::contiguous_range In, std::ranges::contiguous_range Out, typename F>
+auto parallel_transform(work_stealing_executor& executor,
+                        const In&               in,
+                        Out&&                   out,
+                        F                       f,
+                        error_policy            policy = error_policy::run_all,
+                        size_t                  grain = 0)
+{
+  using result_type = std::invoke_result_t<F&, const std::ranges::range_value_t<In>&>;
+  static_assert(expected64_detail::is_expected64<result_type>::value, "f must return an expected64");
+  using E = typename result_type::error_type;
+
+  const size_t n = std::ranges::size(in);
+  const auto*  src = std::ranges::data(in);
+  auto*        dst = std::ranges::data(out);
+  grain = expected64_detail::chunk_grain(n, grain, executor.concurrency());
+
+  expected64_detail::first_error<E> first(n);
+  executor.for_each_chunk(expected64_detail::chunk_count(n, grain),
+                          [&](size_t chunk)
+                          {
+                            const size_t begin = chunk * grain;
+                            const size_t end = std::min(n, begin + grain);
+                            bool         any_error = false;
+                            for (size_t i = begin; i < end; ++i) {
+                              result_type chunk_result = f(src[i]);
+                              any_error |= chunk_result.has_error();
+                              dst[i] = chunk_result;
+                            }
+                            if (!any_error) {
+                              return true;
+                            }
+                            for (size_t i = begin; i < end; ++i) {
+                              if (dst[i].has_error()) {
+                                first.offer(i, dst[i].get_error());
+                                break;
+                              }
+                            }
+                            return policy == error_policy::run_all;
+                          });
+
+  return first.found(n) ? expected64<uint64_t, E>(first.get()) : expected64<uint64_t, E>(static_cast<uint64_t>(n));
+}
+
+/**
+ * @brief Calls f(in[i]) for every element, keeping only the lowest-index error
+ */
+template<std::ranges::contiguous_range In, typename F>
+auto parallel_for_each(work_stealing_executor& executor,
+                       const In&               in,
+                       F                       f,
+                       error_policy            policy = error_policy::run_all,
+                       size_t                  grain = 0)
+{
+  using result_type = std::invoke_result_t<F&, const std::ranges::range_value_t<In>&>;
+  static_assert(expected64_detail::is_expected64<result_type>::value, "f must return an expected64");
+  using E = typename result_type::error_type;
+
+  const size_t n = std::ranges::size(in);
+  const auto*  src = std::ranges::data(in);
+  grain = expected64_detail::chunk_grain(n, grain, executor.concurrency());
+
+  expected64_detail::first_error<E> first(n);
+  executor.for_each_chunk(expected64_detail::chunk_count(n, grain),
+                          [&](size_t chunk)
+                          {
+                            const size_t begin = chunk * grain;
+                            const size_t end = std::min(n, begin + grain);
+                            for (size_t i = begin; i < end; ++i) {
+                              result_type chunk_result = f(src[i]);
+                              if (chunk_result.has_error()) {
+                                first.offer(i, chunk_result.get_error());
+                                return policy == error_policy::run_all;
+                              }
+                            }
+                            return true;
+                          });
+
+  return first.found(n) ? expected64<uint64_t, E>(first.get()) : expected64<uint64_t, E>(static_cast<uint64_t>(n));
+}
+
+/**
+ * @brief Folds the values of f(in[i]) with combine, or returns the lowest-index error
+ *
+ * Each chunk is folded on its own and the partial results are combined in chunk order starting from init, so the
+ * result does not depend on scheduling even for non-associative floating point sums.
+ */
+template<std::ranges::contiguous_range In, typename F, typename Combine>
+auto parallel_reduce(work_stealing_executor& executor,
+                     const In&               in,
+                     typename std::invoke_result_t<F&, const std::ranges::range_value_t<In>&>::value_type init,
+                     F                       f,
+                     Combine                 combine,
+                     error_policy            policy = error_policy::stop_on_first_error,
+                     size_t                  grain = 0)
+{
+  using result_type = std::invoke_result_t<F&, const std::ranges::range_value_t<In>&>;
+  static_assert(expected64_detail::is_expected64<result_type>::value, "f must return an expected64");
+  using T = typename result_type::value_type;
+  using E = typename result_type::error_type;
+
+  const size_t n = std::ranges::size(in);
+  const auto*  src = std::ranges::data(in);
+  grain = expected64_detail::chunk_grain(n, grain, executor.concurrency());
+
+  std::vector<std::optional<T>>     partials(expected64_detail::chunk_count(n, grain));
+  expected64_detail::first_error<E> first(n);
+  executor.for_each_chunk(partials.size(),
+                          [&](size_t chunk)
+                          {
+                            const size_t     begin = chunk * grain;
+                            const size_t     end = std::min(n, begin + grain);
+                            std::optional<T> acc;
+                            for (size_t i = begin; i < end; ++i) {
+                              result_type chunk_result = f(src[i]);
+                              if (chunk_result.has_error()) {
+                                first.offer(i, chunk_result.get_error());
+                                return policy == error_policy::run_all;
+                              }
+                              acc = acc ? combine(*acc, chunk_result.get_value()) : chunk_result.get_value();
+                            }
+                            partials[chunk] = acc;
+                            return true;
+                          });
+
+  if (first.found(n)) {
+    return result_type(first.get());
+  }
+  T total = init;
+  for (const auto& partial : partials) {
+    if (partial) {
+      total = combine(total, *partial);
+    }
+  }
+  return result_type(total);
+}
+
+/**
+ * @brief Index of the first error in results, or results.size() when every result is valid
+ *
+ * Each chunk ORs error_msb() over its words and branches once, so a chunk with no error costs no per-element branch.
+ * Chunks that start after the best error found so far are skipped, and the lowest index always wins.
+ */
+template<std::ranges::contiguous_range Results>
+size_t parallel_first_error(work_stealing_executor& executor, const Results& results, size_t grain = 0)
+{
+  using result_type = std::ranges::range_value_t<Results>;
+  static_assert(expected64_detail::is_expected64<result_type>::value, "results must hold expected64");
+
+  const size_t n = std::ranges::size(results);
+  const auto*  src = std::ranges::data(results);
+  grain = expected64_detail::chunk_grain(n, grain, executor.concurrency());
+
+  std::atomic<size_t> first(n);
+  executor.for_each_chunk(expected64_detail::chunk_count(n, grain),
+                          [&](size_t chunk)
+                          {
+                            const size_t begin = chunk * grain;
+                            const size_t end = std::min(n, begin + grain);
+                            if (begin >= first.load(std::memory_order_relaxed)) {
+                              return true;
+                            }
+                            uint64_t any_error = 0;
+                            for (size_t i = begin; i < end; ++i) {
+                              any_error |= result_type::error_msb(src[i].to_bits());
+                            }
+                            if (any_error == 0) {
+                              return true;
+                            }
+                            size_t at = begin;
+                            while (!src[at].has_error()) {
+                              ++at;
+                            }
+                            size_t best = first.load(std::memory_order_relaxed);
+                            while (at < best && !first.compare_exchange_weak(best, at, std::memory_order_relaxed)) {
+                            }
+                            return true;
+                          });
+  return first.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Span form of when_all: the number of results when all are valid, otherwise the lowest-index error
+ */
+template<std::ranges::contiguous_range Results>
+auto parallel_when_all(work_stealing_executor& executor, const Results& results, size_t grain = 0)
+{
+  using E = typename std::ranges::range_value_t<Results>::error_type;
+
+  const size_t n = std::ranges::size(results);
+  const size_t at = parallel_first_error(executor, results, grain);
+  return at == n ? expected64<uint64_t, E>(static_cast<uint64_t>(n))
+                 : expected64<uint64_t, E>(std::ranges::data(results)[at].get_error());
+}
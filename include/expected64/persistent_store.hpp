@@ -0,0 +1,359 @@
+#pragma once
+#include <algorithm>  // std::max
+#include <bit>  // std::bit_ceil
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "expected64/expected64.hpp"
+
+template<typename K, typename Result>
+class persistent_store;
+
+/**
+ * @brief Open-addressing table of int64_t/uint64_t keys to expected64 results living in a memory-mapped file
+ *
+ * A slot is the key and the result word, nothing else. Empty and deleted slots are marked with
+ * expected64::reserved() words, so a fresh file is filled with the empty marker rather than zeroes.
+ *
+ * Every update publishes with a single 8-byte store of the result word, after the key when a slot is claimed, so a
+ * process that dies mid-update leaves either the old or the new entry. The header records whether the file was closed
+ * cleanly; if not, the next open recounts the slots. Power loss is covered only up to the last flush().
+ *
+ * Erasing leaves a deleted marker in the slot, reused by later inserts that probe past it. Markers at the end of a
+ * probe sequence become empty again right away; the others count towards the 3/4 fill limit until compact() rewrites
+ * the file without them.
+ *
+ * Lookups may run concurrently with each other, updates need external synchronisation.
+ */
+template<typename K, Expected64Type T, typename E, typename P>
+class persistent_store<K, expected64<T, E, P>>
+{
+  static_assert(std::is_same_v<K, int64_t> || std::is_same_v<K, uint64_t>, "Keys must be int64_t or uint64_t");
+  static_assert(!std::is_pointer_v<T>, "Pointers do not survive a restart");
+
+public:
+  using key_type = K;
+  using result_type = expected64<T, E, P>;
+
+private:
+  struct slot
+  {
+    K        key;
+    uint64_t word;
+  };
+
+  struct header
+  {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t layout;  // Encoding of T, sizeof(E) and K, so a file is never read with the wrong types
+    uint64_t capacity;
+    uint64_t live;
+    uint64_t used;  // Live plus deleted slots, bounds probe lengths
+    uint64_t clean;
+    uint64_t reserved[2];
+  };
+  static_assert(sizeof(header) == 64);
+
+  static constexpr uint64_t magic_value = 0x4552'4F54'5334'3645;  // "E64STORE"
+  static constexpr uint32_t version_value = 1;
+
+  static constexpr uint32_t layout_value = (std::is_same_v<T, int64_t>          ? 1U
+                                            : std::is_same_v<T, uint64_t>       ? 2U
+                                            : std::is_same_v<P, any_nan_policy> ? 3U
+                                                                                : 4U)
+      | (static_cast<uint32_t>(sizeof(E)) << 8) | (std::is_same_v<K, int64_t> ? 0x10000U : 0x20000U);
+
+  static uint64_t empty_word() noexcept { return result_type::reserved(0).to_bits(); }
+  static uint64_t deleted_word() noexcept { return result_type::reserved(1).to_bits(); }
+
+  std::string file_path;
+  int         fd = -1;
+  size_t      mapped_bytes = 0;
+  header*     head = nullptr;
+  slot*       slots = nullptr;
+  size_t      mask = 0;
+  bool        was_recovered = false;
+
+  [[noreturn]] static void fail(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+  static uint64_t mix(uint64_t h) noexcept
+  {
+    h ^= h >> 30;
+    h *= 0xBF58'476D'1CE4'E5B9;
+    h ^= h >> 27;
+    h *= 0x94D0'49BB'1331'11EB;
+    return h ^ (h >> 31);
+  }
+
+  // Slots live in the mapped file rather than in std::atomic objects, hence the GCC/Clang builtins
+  static uint64_t load_word(const slot& s) noexcept { return __atomic_load_n(&s.word, __ATOMIC_ACQUIRE); }
+
+  static void store_word(slot& s, uint64_t word) noexcept { __atomic_store_n(&s.word, word, __ATOMIC_RELEASE); }
+
+  // Slot holding key, or nullptr
+  slot* locate(K key) const noexcept
+  {
+    const uint64_t empty = empty_word();
+    const uint64_t deleted = deleted_word();
+    for (size_t i = mix(static_cast<uint64_t>(key)) & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes) {
+      const uint64_t word = load_word(slots[i]);
+      if (word == empty) {
+        return nullptr;
+      }
+      if (word != deleted && slots[i].key == key) {
+        return &slots[i];
+      }
+    }
+    return nullptr;
+  }
+
+  void recount() noexcept
+  {
+    const uint64_t empty = empty_word();
+    const uint64_t deleted = deleted_word();
+    uint64_t       live = 0;
+    uint64_t       used = 0;
+    for (size_t i = 0; i <= mask; ++i) {
+      const uint64_t word = load_word(slots[i]);
+      used += word != empty;
+      live += word != empty && word != deleted;
+    }
+    head->live = live;
+    head->used = used;
+  }
+
+  void map(size_t bytes)
+  {
+    void* addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      fail("persistent_store: mmap");
+    }
+    mapped_bytes = bytes;
+    head = static_cast<header*>(addr);
+    slots = reinterpret_cast<slot*>(static_cast<char*>(addr) + sizeof(header));
+  }
+
+  void create(size_t capacity)
+  {
+    capacity = std::bit_ceil(std::max<size_t>(capacity, 8));
+    const size_t bytes = sizeof(header) + capacity * sizeof(slot);
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      fail("persistent_store: ftruncate");
+    }
+    map(bytes);
+    mask = capacity - 1;
+    const uint64_t empty = empty_word();
+    for (size_t i = 0; i < capacity; ++i) {
+      slots[i] = slot {K {}, empty};
+    }
+    *head = header {0, version_value, layout_value, capacity, 0, 0, 0, {0, 0}};
+    // The magic goes in last: a crash while initialising leaves a file that is simply created again
+    if (::msync(head, mapped_bytes, MS_SYNC) != 0) {
+      fail("persistent_store: msync");
+    }
+    __atomic_store_n(&head->magic, magic_value, __ATOMIC_RELEASE);
+  }
+
+  void open(size_t capacity)
+  {
+    fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      fail("persistent_store: open");
+    }
+    try {
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+        fail("persistent_store: fstat");
+      }
+      const auto size = static_cast<size_t>(st.st_size);
+      bool       existing = false;
+      if (size == 0) {
+        create(capacity);
+      } else {
+        if (size < sizeof(header)) {
+          errno = EINVAL;
+          fail("persistent_store: not a store file");
+        }
+        map(size);
+        const bool ours = head->version == version_value && head->layout == layout_value;
+        const bool unfinished = head->magic == 0 && (ours || head->version == 0)
+                             && (size - sizeof(header)) % sizeof(slot) == 0;
+        if (unfinished) {
+          ::munmap(head, mapped_bytes);  // Crashed while being created
+          head = nullptr;
+          create(capacity);
+        } else if (!ours || head->magic != magic_value || size != sizeof(header) + head->capacity * sizeof(slot)) {
+          errno = EINVAL;
+          fail("persistent_store: incompatible file");
+        } else {
+          mask = head->capacity - 1;
+          existing = true;
+        }
+      }
+
+      was_recovered = existing && head->clean == 0;
+      if (was_recovered) {
+        recount();
+      }
+      head->clean = 0;
+    } catch (...) {
+      if (head != nullptr) {
+        ::munmap(head, mapped_bytes);
+        head = nullptr;
+      }
+      ::close(fd);
+      fd = -1;
+      throw;
+    }
+  }
+
+public:
+  /**
+   * @brief Opens the store at path, creating it with room for capacity entries (rounded up) if it doesn't exist
+   *
+   * Throws std::system_error if the file can't be opened or mapped, or holds a different layout.
+   */
+  persistent_store(const std::string& path, size_t capacity)
+      : file_path(path)
+  {
+    open(capacity);
+  }
+
+  persistent_store(const persistent_store&) = delete;
+  persistent_store& operator=(const persistent_store&) = delete;
+
+  ~persistent_store()
+  {
+    if (head == nullptr) {
+      return;  // compact() failed to reopen the file
+    }
+    ::msync(head, mapped_bytes, MS_SYNC);
+    head->clean = 1;
+    ::msync(head, sizeof(header), MS_SYNC);
+    ::munmap(head, mapped_bytes);
+    ::close(fd);
+  }
+
+  [[nodiscard]] std::optional<result_type> find(K key) const noexcept
+  {
+    if (const slot* s = locate(key)) {
+      return result_type::from_bits(load_word(*s));
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Inserts or overwrites key, returns false when the table is full or result is a reserved marker word
+   *
+   * Deleted slots count as full until compact(), so a store with many erasures may refuse inserts below its size.
+   */
+  bool insert_or_assign(K key, result_type result) noexcept
+  {
+    const uint64_t word = result.to_bits();
+    if (word == empty_word() || word == deleted_word()) {
+      return false;
+    }
+    if (slot* s = locate(key)) {
+      store_word(*s, word);
+      return true;
+    }
+
+    // Keep a quarter of the table empty so probe sequences stay short and always terminate
+    const uint64_t empty = empty_word();
+    const uint64_t deleted = deleted_word();
+    for (size_t i = mix(static_cast<uint64_t>(key)) & mask;; i = (i + 1) & mask) {
+      const uint64_t current = load_word(slots[i]);
+      if (current == deleted || current == empty) {
+        if (current == empty && head->used + 1 > (mask + 1) / 4 * 3) {
+          return false;
+        }
+        slots[i].key = key;
+        store_word(slots[i], word);
+        head->used += current == empty;
+        ++head->live;
+        return true;
+      }
+    }
+  }
+
+  bool erase(K key) noexcept
+  {
+    slot* s = locate(key);
+    if (s == nullptr) {
+      return false;
+    }
+    store_word(*s, deleted_word());
+    --head->live;
+
+    // No probe goes past an empty slot, so markers right before one can become empty too
+    const uint64_t empty = empty_word();
+    const uint64_t deleted = deleted_word();
+    auto           i = static_cast<size_t>(s - slots);
+    if (load_word(slots[(i + 1) & mask]) == empty) {
+      while (load_word(slots[i]) == deleted) {
+        store_word(slots[i], empty);
+        --head->used;
+        i = (i - 1) & mask;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Rewrites the store without deleted slots, so the whole 3/4 of the capacity is available to inserts again
+   *
+   * The live entries go into a new file next to this one, path + ".compact", which then replaces it with rename(): a
+   * crash leaves either the old or the compacted store. No lookups or updates may run concurrently with it.
+   */
+  void compact()
+  {
+    const std::string temporary = file_path + ".compact";
+    ::unlink(temporary.c_str());
+    {
+      persistent_store compacted(temporary, capacity());
+      const uint64_t   empty = empty_word();
+      const uint64_t   deleted = deleted_word();
+      for (size_t i = 0; i <= mask; ++i) {
+        const uint64_t word = load_word(slots[i]);
+        if (word != empty && word != deleted) {
+          compacted.insert_or_assign(slots[i].key, result_type::from_bits(word));
+        }
+      }
+      compacted.flush();
+    }
+    if (::rename(temporary.c_str(), file_path.c_str()) != 0) {
+      fail("persistent_store: rename");
+    }
+    const size_t old_capacity = capacity();
+    ::munmap(head, mapped_bytes);
+    ::close(fd);
+    head = nullptr;
+    fd = -1;
+    open(old_capacity);
+  }
+
+  // Writes dirty pages back to the file, the durability point against power loss
+  void flush()
+  {
+    if (::msync(head, mapped_bytes, MS_SYNC) != 0) {
+      fail("persistent_store: msync");
+    }
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return head->live; }
+  [[nodiscard]] size_t capacity() const noexcept { return mask + 1; }
+
+  // True when the file was not closed cleanly and its counts were rebuilt on open
+  [[nodiscard]] bool recovered() const noexcept { return was_recovered; }
+};
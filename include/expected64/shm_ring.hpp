@@ -0,0 +1,337 @@
+#pragma once
+#include <algorithm>  // std::max
+#include <atomic>
+#include <bit>  // std::bit_ceil
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <signal.h>  // kill
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "expected64/expected64.hpp"
+
+template<typename Result>
+class shm_ring_writer;
+
+template<typename Result>
+class shm_ring_reader;
+
+namespace expected64_detail
+{
+/**
+ * @brief The shared memory segment behind shm_ring_writer and shm_ring_reader
+ *
+ * A 64-byte header followed by a power-of-two number of slots. Message n goes to slot n % capacity, whose sequence
+ * word is 2n + 1 while the writer stores the result word and 2n + 2 once it is complete, so the sequence alone tells a
+ * reader whether the slot holds the message it wants, an older one or a newer one.
+ */
+struct shm_ring_segment
+{
+  struct slot
+  {
+    uint64_t sequence;
+    uint64_t word;
+  };
+
+  struct header
+  {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t layout;  // Encoding of T and sizeof(E), so a segment is never read with the wrong types
+    uint64_t capacity;
+    uint64_t published;  // Messages published so far
+    uint64_t writer;  // pid of the attached writer, 0 if none
+    uint64_t reserved[3];
+  };
+  static_assert(sizeof(header) == 64);
+
+  static constexpr uint64_t magic_value = 0x474E'4952'3436'4545;  // "EE64RING"
+  static constexpr uint32_t version_value = 1;
+
+  int     fd = -1;
+  size_t  mapped_bytes = 0;
+  header* head = nullptr;
+  slot*   slots = nullptr;
+  size_t  mask = 0;
+
+  [[noreturn]] static void fail(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+  static uint64_t load(const uint64_t& word, std::memory_order order = std::memory_order_acquire) noexcept
+  {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(word)).load(order);
+  }
+
+  static void store(uint64_t& word, uint64_t value, std::memory_order order = std::memory_order_release) noexcept
+  {
+    std::atomic_ref<uint64_t>(word).store(value, order);
+  }
+
+  void map(size_t bytes, int prot)
+  {
+    void* addr = ::mmap(nullptr, bytes, prot, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      fail("shm_ring: mmap");
+    }
+    mapped_bytes = bytes;
+    head = static_cast<header*>(addr);
+    slots = reinterpret_cast<slot*>(static_cast<char*>(addr) + sizeof(header));
+  }
+
+  // Maps an existing, initialised segment, throws EAGAIN while its creator is still initialising it
+  void attach(const std::string& name, bool writable, uint32_t layout)
+  {
+    fd = ::shm_open(name.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC, 0);
+    if (fd < 0) {
+      fail("shm_ring: shm_open");
+    }
+    try {
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+        fail("shm_ring: fstat");
+      }
+      const auto size = static_cast<size_t>(st.st_size);
+      if (size < sizeof(header)) {
+        errno = EAGAIN;
+        fail("shm_ring: segment not initialised");
+      }
+      map(size, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+      if (load(head->magic) != magic_value) {
+        errno = EAGAIN;
+        fail("shm_ring: segment not initialised");
+      }
+      if (head->version != version_value || head->layout != layout
+          || size != sizeof(header) + head->capacity * sizeof(slot)) {
+        errno = EINVAL;
+        fail("shm_ring: incompatible segment");
+      }
+      mask = head->capacity - 1;
+    } catch (...) {
+      detach();
+      throw;
+    }
+  }
+
+  // Creates the segment, or attaches to it when it already exists
+  void create_or_attach(const std::string& name, size_t capacity, uint32_t layout)
+  {
+    for (int attempt = 0;; ++attempt) {
+      fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+      if (fd >= 0) {
+        break;
+      }
+      if (errno != EEXIST) {
+        fail("shm_ring: shm_open");
+      }
+      try {
+        attach(name, true, layout);
+        return;
+      } catch (const std::system_error& e) {
+        if (e.code() != std::errc::resource_unavailable_try_again) {
+          throw;
+        }
+      }
+      // Still uninitialised after a second, so its creator died: start over with a new segment
+      if (attempt == 1000) {
+        ::shm_unlink(name.c_str());
+      } else {
+        ::usleep(1000);
+      }
+    }
+
+    try {
+      capacity = std::bit_ceil(std::max<size_t>(capacity, 8));
+      const size_t bytes = sizeof(header) + capacity * sizeof(slot);
+      if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        fail("shm_ring: ftruncate");
+      }
+      map(bytes, PROT_READ | PROT_WRITE);
+      mask = capacity - 1;
+      *head = header {0, version_value, layout, capacity, 0, 0, {0, 0, 0}};
+      // New segments are zero-filled, so every slot already reads as never written. The magic goes in last.
+      store(head->magic, magic_value);
+    } catch (...) {
+      detach();
+      ::shm_unlink(name.c_str());
+      throw;
+    }
+  }
+
+  void detach() noexcept
+  {
+    if (head != nullptr) {
+      ::munmap(head, mapped_bytes);
+      head = nullptr;
+    }
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+};
+
+template<typename T, typename E, typename P>
+inline constexpr uint32_t shm_ring_layout = (std::is_same_v<T, int64_t>          ? 1U
+                                             : std::is_same_v<T, uint64_t>       ? 2U
+                                             : std::is_same_v<P, any_nan_policy> ? 3U
+                                                                                 : 4U)
+                                          | (static_cast<uint32_t>(sizeof(E)) << 8);
+}  // namespace expected64_detail
+
+/**
+ * @brief Publishes expected64 results into a named shared memory ring that any number of processes can read
+ *
+ * There is one writer per ring. Attaching creates the segment, or takes over an existing one whose writer has
+ * detached or died, including one that died while creating it. A live writer makes the constructor throw
+ * std::system_error with EBUSY. Publishing continues at the
+ * ring's head, so a restarted writer never reuses a sequence number. A writer that dies in the middle of publish()
+ * leaves that message unfinished, and its replacement writes it again. The segment outlives all processes until
+ * remove() is called.
+ */
+template<Expected64Type T, typename E, typename P>
+class shm_ring_writer<expected64<T, E, P>>
+{
+  static_assert(!std::is_pointer_v<T>, "Pointers are meaningless in another process");
+
+public:
+  using result_type = expected64<T, E, P>;
+
+private:
+  using segment = expected64_detail::shm_ring_segment;
+
+  segment  ring;
+  uint64_t next = 0;
+
+public:
+  /**
+   * @brief Creates the ring name (a shm_open name, "/something") with room for capacity results, or attaches to it
+   *
+   * capacity is rounded up to a power of two and ignored when the ring exists.
+   */
+  shm_ring_writer(const std::string& name, size_t capacity)
+  {
+    ring.create_or_attach(name, capacity, expected64_detail::shm_ring_layout<T, E, P>);
+    const auto                self = static_cast<uint64_t>(::getpid());
+    std::atomic_ref<uint64_t> writer(ring.head->writer);
+    uint64_t                  owner = writer.load(std::memory_order_acquire);
+    do {
+      if (owner != 0 && (owner == self || ::kill(static_cast<pid_t>(owner), 0) == 0 || errno == EPERM)) {
+        ring.detach();
+        errno = EBUSY;
+        segment::fail("shm_ring_writer: ring has a live writer");
+      }
+      // Detached or dead writer, claim the ring unless another process just did
+    } while (!writer.compare_exchange_weak(owner, self, std::memory_order_acq_rel));
+    next = segment::load(ring.head->published);
+  }
+
+  shm_ring_writer(const shm_ring_writer&) = delete;
+  shm_ring_writer& operator=(const shm_ring_writer&) = delete;
+
+  ~shm_ring_writer()
+  {
+    segment::store(ring.head->writer, 0);
+    ring.detach();
+  }
+
+  void publish(result_type result) noexcept
+  {
+    segment::slot& s = ring.slots[next & ring.mask];
+    segment::store(s.sequence, 2 * next + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment::store(s.word, result.to_bits(), std::memory_order_relaxed);
+    segment::store(s.sequence, 2 * next + 2);
+    segment::store(ring.head->published, ++next);
+  }
+
+  // Sequence number of the next message
+  [[nodiscard]] uint64_t position() const noexcept { return next; }
+
+  [[nodiscard]] size_t capacity() const noexcept { return ring.mask + 1; }
+
+  // Deletes the name; processes that have the ring mapped keep using it
+  static void remove(const std::string& name) noexcept { ::shm_unlink(name.c_str()); }
+};
+
+/**
+ * @brief Reads the results of a shm_ring_writer, in order, from any process
+ *
+ * A reader keeps nothing in the segment, so it can detach or die at any time without affecting the writer or other
+ * readers. It starts at the ring's head and only sees later messages; seek() resumes at a position saved earlier.
+ * When the writer laps a slow reader, the reader skips to the oldest message still in the ring and counts the ones it
+ * missed in lost(). Throws std::system_error from the constructor if the ring doesn't exist (ENOENT), is still being
+ * created (EAGAIN) or holds another result type (EINVAL).
+ */
+template<Expected64Type T, typename E, typename P>
+class shm_ring_reader<expected64<T, E, P>>
+{
+  static_assert(!std::is_pointer_v<T>, "Pointers are meaningless in another process");
+
+public:
+  using result_type = expected64<T, E, P>;
+
+private:
+  using segment = expected64_detail::shm_ring_segment;
+
+  segment  ring;
+  uint64_t next = 0;
+  uint64_t missed = 0;
+
+public:
+  explicit shm_ring_reader(const std::string& name)
+  {
+    ring.attach(name, false, expected64_detail::shm_ring_layout<T, E, P>);
+    next = segment::load(ring.head->published);
+  }
+
+  shm_ring_reader(const shm_ring_reader&) = delete;
+  shm_ring_reader& operator=(const shm_ring_reader&) = delete;
+
+  ~shm_ring_reader() { ring.detach(); }
+
+  // The next message, or nothing if the writer hasn't published it yet
+  [[nodiscard]] std::optional<result_type> try_read() noexcept
+  {
+    for (;;) {
+      const segment::slot& s = ring.slots[next & ring.mask];
+      const uint64_t       expected = 2 * next + 2;
+      const uint64_t       before = segment::load(s.sequence);
+      if (before == expected) {
+        const uint64_t word = segment::load(s.word, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment::load(s.sequence, std::memory_order_relaxed) == expected) {
+          ++next;
+          return result_type::from_bits(word);
+        }
+      } else if (before < expected) {
+        return std::nullopt;
+      }
+      // Overwritten by a later message: continue with the oldest one the writer can't be overwriting yet
+      const uint64_t published = segment::load(ring.head->published);
+      const uint64_t oldest = std::max(published > ring.mask ? published - ring.mask : 0, next + 1);
+      missed += oldest - next;
+      next = oldest;
+    }
+  }
+
+  // Messages skipped because the writer overwrote them before they were read
+  [[nodiscard]] uint64_t lost() const noexcept { return missed; }
+
+  // Sequence number of the next message
+  [[nodiscard]] uint64_t position() const noexcept { return next; }
+
+  // Continues at sequence number position, e.g. one saved before a restart
+  void seek(uint64_t position) noexcept { next = position; }
+
+  // Messages published but not read yet, including any that will turn out to be lost
+  [[nodiscard]] uint64_t backlog() const noexcept { return segment::load(ring.head->published) - next; }
+
+  [[nodiscard]] size_t capacity() const noexcept { return ring.mask + 1; }
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief System calls returning expected64 instead of -1 and errno
+ *
+ * The kernel returns -errno in the result register on failure. The wrappers issue the system call directly and encode
+ * that value into the error bits, so a failed call costs neither the libc branch that stores errno nor the
+ * thread-local load that reads it back. Linux only; on architectures without an inline system call here they go
+ * through syscall(2) and read errno once.
+ */
+
+namespace expected64_detail
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+inline long raw_syscall(long number, long a = 0, long b = 0, long c = 0, long d = 0, long e = 0, long f = 0) noexcept
+{
+  register long r10 __asm__("r10") = d;
+  register long r8 __asm__("r8") = e;
+  register long r9 __asm__("r9") = f;
+  long          ret;
+  __asm__ volatile("syscall"
+                   : "=a"(ret)
+                   : "a"(number), "D"(a), "S"(b), "d"(c), "r"(r10), "r"(r8), "r"(r9)
+                   : "rcx", "r11", "memory");
+  return ret;
+}
+#elif defined(__GNUC__) && defined(__aarch64__)
+inline long raw_syscall(long number, long a = 0, long b = 0, long c = 0, long d = 0, long e = 0, long f = 0) noexcept
+{
+  register long x8 __asm__("x8") = number;
+  register long x0 __asm__("x0") = a;
+  register long x1 __asm__("x1") = b;
+  register long x2 __asm__("x2") = c;
+  register long x3 __asm__("x3") = d;
+  register long x4 __asm__("x4") = e;
+  register long x5 __asm__("x5") = f;
+  __asm__ volatile("svc 0" : "+r"(x0) : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5) : "memory");
+  return x0;
+}
+#else
+inline long raw_syscall(long number, long a = 0, long b = 0, long c = 0, long d = 0, long e = 0, long f = 0) noexcept
+{
+  const long ret = ::syscall(number, a, b, c, d, e, f);
+  return ret == -1 ? -errno : ret;
+}
+#endif
+
+inline long syscall_arg(const void* pointer) noexcept
+{
+  return reinterpret_cast<long>(pointer);
+}
+}  // namespace expected64_detail
+
+namespace sys
+{
+using result = expected64<int64_t, std::errc>;
+
+// A count or offset, or -errno turned into the word set_error() would store
+[[nodiscard]] inline result from_return(long ret EXPECTED64_ERROR_SITE) noexcept
+{
+#if defined(EXPECTED64_ERROR_COUNTERS) || defined(EXPECTED64_ERROR_TRACE)
+  return ret < 0 ? result(static_cast<std::errc>(-ret) EXPECTED64_PASS_ERROR_SITE) : result(int64_t {ret});
+#else
+  const auto     count = static_cast<uint64_t>(ret);
+  const uint64_t negative = 0 - (count >> 63);
+  return result::from_bits((count & ~negative) | ((result::error_bits(std::errc {}) | (0 - count)) & negative));
+#endif
+}
+
+[[nodiscard]] inline result read(int fd, void* buf, size_t count EXPECTED64_ERROR_SITE) noexcept
+{
+  const long ret =
+      expected64_detail::raw_syscall(SYS_read, fd, expected64_detail::syscall_arg(buf), static_cast<long>(count));
+  return from_return(ret EXPECTED64_PASS_ERROR_SITE);
+}
+
+[[nodiscard]] inline result write(int fd, const void* buf, size_t count EXPECTED64_ERROR_SITE) noexcept
+{
+  const long ret =
+      expected64_detail::raw_syscall(SYS_write, fd, expected64_detail::syscall_arg(buf), static_cast<long>(count));
+  return from_return(ret EXPECTED64_PASS_ERROR_SITE);
+}
+
+[[nodiscard]] inline result pread(int fd, void* buf, size_t count, off_t offset EXPECTED64_ERROR_SITE) noexcept
+{
+  const long ret = expected64_detail::raw_syscall(SYS_pread64, fd, expected64_detail::syscall_arg(buf),
+                                                  static_cast<long>(count), offset);
+  return from_return(ret EXPECTED64_PASS_ERROR_SITE);
+}
+
+// The new offset from the start of the file
+[[nodiscard]] inline result lseek(int fd, off_t offset, int whence EXPECTED64_ERROR_SITE) noexcept
+{
+  return from_return(expected64_detail::raw_syscall(SYS_lseek, fd, offset, whence) EXPECTED64_PASS_ERROR_SITE);
+}
+
+/**
+ * @brief The address of the new mapping as an integer, or the error
+ *
+ * Not an expected64<void*, std::errc>: pointers flag errors in the LSB, which would drop bit 0 of odd errno values.
+ * User-space addresses are below 2^57, so they are always valid int64_t results. Use mapping() for the pointer.
+ */
+[[nodiscard]] inline result mmap(void* addr, size_t length, int prot, int flags, int fd,
+                                 off_t offset EXPECTED64_ERROR_SITE) noexcept
+{
+  const long ret = expected64_detail::raw_syscall(SYS_mmap, expected64_detail::syscall_arg(addr),
+                                                  static_cast<long>(length), prot, flags, fd, offset);
+  return from_return(ret EXPECTED64_PASS_ERROR_SITE);
+}
+
+// The pointer held by a successful mmap() result
+[[nodiscard]] inline void* mapping(result mapped) noexcept
+{
+  return reinterpret_cast<void*>(mapped.get_value());
+}
+}  // namespace sys
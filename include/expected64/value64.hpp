@@ -0,0 +1,262 @@
+#pragma once
+#include <bit>  // std::bit_cast
+#include <cassert>
+#include <cmath>  // std::isnan
+#include <cstddef>  // std::nullptr_t
+#include <cstdint>
+#include <type_traits>
+
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief NaN-boxed dynamic value holding a double, 48-bit int, bool, null, pointer or error in 8 bytes
+ *
+ * Doubles are stored unchanged. Everything else lives in the quiet NaN space that expected64 uses for double errors,
+ * with the sign bit set, a 3 bit tag and a 48 bit payload:
+ *
+ *   63                                                                  0
+ *  |---------------------------------------------------------------------|
+ *  | 1 | 11111111111 | 1 | tag | payload (48 bits)                       |
+ *  |---------------------------------------------------------------------|
+ *
+ * Tag 0 is left to the doubles because it is the NaN x86 produces for 0/0. Any NaN passed in is canonicalised to a
+ * positive quiet NaN, so a double can never be mistaken for a boxed value.
+ */
+template<typename E>
+class value64
+{
+  static_assert(sizeof(E) <= 4, "E must fit in the 48-bit payload");
+  static_assert(std::is_trivially_copyable<E>::value, "E must be trivially copyable");
+
+  uint64_t bits;
+
+  static constexpr uint64_t box_prefix = 0xFFF8'0000'0000'0000;  // Negative quiet NaN
+  static constexpr unsigned tag_shift = 48;
+  static constexpr uint64_t payload_mask = 0x0000'FFFF'FFFF'FFFF;
+  static constexpr uint64_t canonical_nan = 0x7FF8'0000'0000'0000;
+  static constexpr int64_t  int_min = -(static_cast<int64_t>(1) << 47);
+  static constexpr int64_t  int_max = (static_cast<int64_t>(1) << 47) - 1;
+
+public:
+  enum class kind : uint8_t
+  {
+    number = 0,
+    integer,
+    boolean,
+    null,
+    pointer,
+    error
+  };
+
+private:
+  static constexpr uint64_t prefix_of(kind k) { return box_prefix | (static_cast<uint64_t>(k) << tag_shift); }
+
+  static constexpr uint64_t tag_of(kind k) { return prefix_of(k) >> tag_shift; }
+
+  static constexpr uint64_t first_boxed = prefix_of(kind::integer);
+
+  constexpr explicit value64(uint64_t raw_bits) noexcept
+      : bits(raw_bits)
+  {
+  }
+
+  static constexpr value64 box(kind k, uint64_t payload) noexcept { return value64(prefix_of(k) | payload); }
+
+  [[nodiscard]] constexpr uint64_t payload() const noexcept { return bits & payload_mask; }
+
+public:
+  // Default constructed values are null
+  constexpr value64() noexcept
+      : bits(prefix_of(kind::null))
+  {
+  }
+
+  static value64 from_double(double d) noexcept
+  {
+    return value64(std::isnan(d) ? canonical_nan : std::bit_cast<uint64_t>(d));
+  }
+
+  // Integers outside the 48-bit range are stored as doubles
+  static constexpr value64 from_int(int64_t i) noexcept
+  {
+    if (i < int_min || i > int_max) {
+      return value64(std::bit_cast<uint64_t>(static_cast<double>(i)));
+    }
+    return box(kind::integer, static_cast<uint64_t>(i) & payload_mask);
+  }
+
+  static constexpr value64 from_bool(bool b) noexcept { return box(kind::boolean, static_cast<uint64_t>(b)); }
+
+  static constexpr value64 null() noexcept { return value64(); }
+
+  /**
+   * @brief Boxes a pointer whose upper 16 bits are clear
+   *
+   * LA57 addresses and TBI/MTE tagged pointers don't fit and fail the assertion. Without assertions their upper bits
+   * are dropped rather than overwriting the tag.
+   */
+  static value64 from_pointer(const void* p) noexcept
+  {
+    const auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p));
+    assert((address & ~payload_mask) == 0 && "pointer does not fit the 48-bit payload");
+    return box(kind::pointer, address & payload_mask);
+  }
+
+  static constexpr value64 from_error(E error_value) noexcept
+  {
+    return box(kind::error, static_cast<uint64_t>(error_value) & 0xFFFF'FFFF);
+  }
+
+  template<typename T, typename P>
+  static value64 from_expected(const expected64<T, E, P>& result) noexcept
+  {
+    if (result.has_error()) {
+      return from_error(result.get_error());
+    }
+    if constexpr (std::is_same_v<T, double>) {
+      return from_double(result.get_value());
+    } else if constexpr (std::is_pointer_v<T>) {
+      return from_pointer(result.get_value());
+    } else {
+      return from_int(static_cast<int64_t>(result.get_value()));
+    }
+  }
+
+  [[nodiscard]] constexpr kind type() const noexcept
+  {
+    return bits < first_boxed ? kind::number : static_cast<kind>((bits >> tag_shift) & 0x7);
+  }
+
+  [[nodiscard]] constexpr bool is_double() const noexcept { return bits < first_boxed; }
+  [[nodiscard]] constexpr bool is_int() const noexcept { return (bits >> tag_shift) == tag_of(kind::integer); }
+  [[nodiscard]] constexpr bool is_bool() const noexcept { return (bits >> tag_shift) == tag_of(kind::boolean); }
+  [[nodiscard]] constexpr bool is_null() const noexcept { return bits == prefix_of(kind::null); }
+  [[nodiscard]] constexpr bool is_pointer() const noexcept { return (bits >> tag_shift) == tag_of(kind::pointer); }
+  [[nodiscard]] constexpr bool has_error() const noexcept { return (bits >> tag_shift) == tag_of(kind::error); }
+  [[nodiscard]] constexpr bool is_number() const noexcept { return is_double() || is_int(); }
+
+  [[nodiscard]] constexpr double as_double() const noexcept { return std::bit_cast<double>(bits); }
+
+  [[nodiscard]] constexpr int64_t as_int() const noexcept { return static_cast<int64_t>(bits << 16) >> 16; }
+
+  [[nodiscard]] constexpr bool as_bool() const noexcept { return (bits & 1) != 0; }
+
+  template<typename P = const void*>
+  [[nodiscard]] P as_pointer() const noexcept
+  {
+    return reinterpret_cast<P>(static_cast<uintptr_t>(payload()));
+  }
+
+  [[nodiscard]] constexpr E get_error() const noexcept { return static_cast<E>(payload()); }
+
+  // Ints are widened, callers must check is_number() first
+  [[nodiscard]] constexpr double to_double() const noexcept
+  {
+    return is_int() ? static_cast<double>(as_int()) : as_double();
+  }
+
+  [[nodiscard]] constexpr uint64_t raw_bits() const noexcept { return bits; }
+
+  /**
+   * @brief Calls f with the held value as double, int64_t, bool, std::nullptr_t, const void* or E
+   */
+  template<typename F>
+  decltype(auto) visit(F&& f) const
+  {
+    switch (type()) {
+      case kind::number:
+        return f(as_double());
+      case kind::integer:
+        return f(as_int());
+      case kind::boolean:
+        return f(as_bool());
+      case kind::null:
+        return f(nullptr);
+      case kind::pointer:
+        return f(as_pointer());
+      default:
+        return f(get_error());
+    }
+  }
+
+  // Both operands are ints: one branch on the combined tag bits
+  [[nodiscard]] friend constexpr bool both_int(value64 lhs, value64 rhs) noexcept
+  {
+    return (((lhs.bits ^ prefix_of(kind::integer)) | (rhs.bits ^ prefix_of(kind::integer))) >> tag_shift) == 0;
+  }
+
+  [[nodiscard]] friend constexpr bool both_double(value64 lhs, value64 rhs) noexcept
+  {
+    return (lhs.bits < first_boxed) & (rhs.bits < first_boxed);
+  }
+
+  template<typename IntOp, typename DoubleOp>
+  static value64 arithmetic(value64 lhs, value64 rhs, E type_error, IntOp int_op, DoubleOp double_op) noexcept
+  {
+    if (both_int(lhs, rhs)) {
+      int64_t result;
+      if (!int_op(lhs.as_int(), rhs.as_int(), result)) {
+        return from_int(result);
+      }
+    } else if (both_double(lhs, rhs)) {
+      return from_double(double_op(lhs.as_double(), rhs.as_double()));
+    }
+
+    // Slow path: errors propagate left to right, mixed int/double widen to double
+    if (lhs.has_error()) {
+      return lhs;
+    }
+    if (rhs.has_error()) {
+      return rhs;
+    }
+    if (!lhs.is_number() || !rhs.is_number()) {
+      return from_error(type_error);
+    }
+    return from_double(double_op(lhs.to_double(), rhs.to_double()));
+  }
+};
+
+template<typename E>
+value64<E> add(value64<E> lhs, value64<E> rhs, E type_error) noexcept
+{
+  return value64<E>::arithmetic(
+      lhs,
+      rhs,
+      type_error,
+      [](int64_t a, int64_t b, int64_t& r) { return __builtin_add_overflow(a, b, &r); },
+      [](double a, double b) { return a + b; });
+}
+
+template<typename E>
+value64<E> sub(value64<E> lhs, value64<E> rhs, E type_error) noexcept
+{
+  return value64<E>::arithmetic(
+      lhs,
+      rhs,
+      type_error,
+      [](int64_t a, int64_t b, int64_t& r) { return __builtin_sub_overflow(a, b, &r); },
+      [](double a, double b) { return a - b; });
+}
+
+template<typename E>
+value64<E> mul(value64<E> lhs, value64<E> rhs, E type_error) noexcept
+{
+  return value64<E>::arithmetic(
+      lhs,
+      rhs,
+      type_error,
+      [](int64_t a, int64_t b, int64_t& r) { return __builtin_mul_overflow(a, b, &r); },
+      [](double a, double b) { return a * b; });
+}
+
+// Division always produces a double, like most expression languages
+template<typename E>
+value64<E> div(value64<E> lhs, value64<E> rhs, E type_error) noexcept
+{
+  return value64<E>::arithmetic(
+      lhs,
+      rhs,
+      type_error,
+      [](int64_t, int64_t, int64_t&) { return true; },
+      [](double a, double b) { return a / b; });
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>  // std::min
+#include <bit>  // std::bit_cast, std::countr_zero
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "expected64/batch_dispatch.hpp"
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief A span of plain doubles or integers read in place as expected64 results
+ *
+ * A valid expected64<double, E> has the bits of the double it holds, and so does an expected64<int64_t, E> in
+ * [-2^62, 2^62) or an expected64<uint64_t, E> below 2^63. A buffer from an external library or a mapped file therefore
+ * already is an array of results, except for the elements that collide with the error encoding: NaNs and integers
+ * outside those ranges, which read as errors. collisions() and is_valid() find them with the batch kernels.
+ *
+ * With tagged_nan_policy only NaNs carrying its tag collide, so a buffer with missing-value NaNs stays valid.
+ *
+ * The view never copies or writes the buffer. It is a contiguous range of expected64, so the parallel algorithms take
+ * it directly, and words() hands the raw words to the batch_* functions.
+ */
+template<typename T, typename E, typename Policy = any_nan_policy>
+class expected64_view
+{
+  static_assert(std::is_same_v<T, double> || std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>,
+                "Views are over doubles or 64-bit integers");
+
+public:
+  using result_type = expected64<T, E, Policy>;
+
+private:
+  static_assert(sizeof(result_type) == sizeof(T) && alignof(result_type) == alignof(T));
+  static_assert(std::is_trivially_copyable_v<result_type>);
+
+  std::span<const T> values;
+
+public:
+  explicit expected64_view(std::span<const T> buffer) noexcept
+      : values(buffer)
+  {
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return values.size(); }
+  [[nodiscard]] bool   empty() const noexcept { return values.empty(); }
+
+  [[nodiscard]] result_type operator[](size_t i) const noexcept
+  {
+    return result_type::from_bits(std::bit_cast<uint64_t>(values[i]));
+  }
+
+  [[nodiscard]] const result_type* data() const noexcept { return reinterpret_cast<const result_type*>(values.data()); }
+  [[nodiscard]] const result_type* begin() const noexcept { return data(); }
+  [[nodiscard]] const result_type* end() const noexcept { return data() + size(); }
+
+  // The buffer as raw words, for the batch_* functions
+  [[nodiscard]] const uint64_t* words() const noexcept { return reinterpret_cast<const uint64_t*>(values.data()); }
+
+  /**
+   * @brief Sets bit i of bits when element i collides with the error encoding and returns the number of collisions
+   *
+   * bits needs (size() + 63) / 64 words.
+   */
+  size_t validate(uint64_t* bits) const noexcept { return batch_error_bits<result_type>(words(), size(), bits); }
+
+  // True when every element reads as the value it holds, stopping at the first block with a collision
+  [[nodiscard]] bool is_valid() const noexcept
+  {
+    constexpr size_t block = 64 * 64;
+    uint64_t         bits[block / 64];
+    for (size_t i = 0; i < size(); i += block) {
+      if (batch_error_bits<result_type>(words() + i, std::min(block, size() - i), bits) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Indices of the elements that collide with the error encoding, in order
+  [[nodiscard]] std::vector<size_t> collisions() const
+  {
+    std::vector<uint64_t> bits((size() + 63) / 64);
+    std::vector<size_t>   indices;
+    indices.reserve(validate(bits.data()));
+    for (size_t w = 0; w < bits.size(); ++w) {
+      for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+        indices.push_back(w * 64 + static_cast<size_t>(std::countr_zero(word)));
+      }
+    }
+    return indices;
+  }
+};
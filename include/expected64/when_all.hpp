@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // std::index_sequence
+
+#include "expected64/expected64.hpp"
+
+/**
+ * @brief Several expected64 results checked together
+ *
+ * has_error() ORs the error_msb() word of every result and tests once. When all inputs share an encoding the OR is
+ * done on the raw words, e.g. (a | b | c) & msb for uint64_t. get_error() returns the leftmost error.
+ */
+template<typename E, typename... Results>
+class when_all_result
+{
+  static_assert(sizeof...(Results) > 0, "when_all needs at least one result");
+  static_assert((std::is_same_v<typename Results::error_type, E> && ...), "All results must share the error type");
+
+  std::tuple<Results...> results;
+
+  template<size_t... I>
+  [[nodiscard]] uint64_t combined_error_msb(std::index_sequence<I...>) const noexcept
+  {
+    return (Results::error_msb(std::get<I>(results).to_bits()) | ...);
+  }
+
+  template<size_t... I>
+  [[nodiscard]] E leftmost_error(std::index_sequence<I...>) const noexcept
+  {
+    E error {};
+    // Short-circuits at the first error, so the leftmost one wins
+    (void)((std::get<I>(results).has_error() ? (error = std::get<I>(results).get_error(), true) : false) || ...);
+    return error;
+  }
+
+public:
+  explicit when_all_result(Results... values) noexcept
+      : results(values...)
+  {
+  }
+
+  [[nodiscard]] inline bool has_error() const noexcept
+  {
+    return combined_error_msb(std::index_sequence_for<Results...> {}) != 0;
+  }
+
+  [[nodiscard]] E get_error() const noexcept { return leftmost_error(std::index_sequence_for<Results...> {}); }
+
+  template<size_t I>
+  [[nodiscard]] inline auto get_value() const noexcept
+  {
+    return std::get<I>(results).get_value();
+  }
+
+  [[nodiscard]] std::tuple<typename Results::value_type...> get_values() const noexcept
+  {
+    return std::apply([](const auto&... r) { return std::make_tuple(r.get_value()...); }, results);
+  }
+
+  template<size_t I>
+  [[nodiscard]] const auto& get() const noexcept
+  {
+    return std::get<I>(results);
+  }
+};
+
+template<typename E, Expected64Type... T, typename... P>
+[[nodiscard]] when_all_result<E, expected64<T, E, P>...> when_all(expected64<T, E, P>... results) noexcept
+{
+  return when_all_result<E, expected64<T, E, P>...>(results...);
+}
@@ -0,0 +1,27 @@
+// Named module over the core headers: import expected64; instead of #include <expected64/expected64.hpp>.
+// The standard headers go into the global module fragment and the expected64 headers are attached to the global
+// module with extern "C++", so the module and the headers declare the same entities and can be mixed in one program.
+// Opt-in features configured with macros (EXPECTED64_ERROR_COUNTERS, EXPECTED64_ERROR_TRACE) need the headers.
+module;
+
+// Every standard header the expected64 headers include, so none of them is parsed inside the module purview
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+export module expected64;
+
+export extern "C++"
+{
+#include "expected64/expected64.hpp"
+#include "expected64/optional64.hpp"
+#include "expected64/value64.hpp"
+}
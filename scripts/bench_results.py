@@ -0,0 +1,246 @@
+"""Record benchmark results as JSON and compare a run against a stored baseline.
+
+Usage:
+  python3 bench_results.py record-catch2 BINARY OUTPUT [CATCH2 ARGS...]
+  python3 bench_results.py record-nanobench BINARY OUTPUT
+  python3 bench_results.py compare BASELINE CURRENT [--threshold 0.05] [--alpha 0.01]
+
+record-catch2 runs expected64_benchmark_catch2 with the XML reporter and picks up
+the hardware counter lines it prints, record-nanobench runs
+expected64_benchmark_nanobench and reads its JSON report. Both write the same
+format: compiler and CPU, then per benchmark the mean and standard deviation in
+ns per operation, the sample count and any counters.
+
+compare runs a one-sided Welch t-test per benchmark present in both files and
+exits with status 1 when any benchmark is slower than the baseline by more than
+THRESHOLD (relative) with p below ALPHA.
+"""
+import argparse
+import datetime
+import json
+import math
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ET
+
+COUNTER_LINE = re.compile(r'^  (.+), per iteration:(.*)$')
+COUNTER_VALUE = re.compile(r'([\d.]+) ([\w-]+)')
+COMPILER_ID = re.compile(rb'(GCC: \([^)]*\) [\w.]+|(?:Apple |Ubuntu |Debian )?clang version [\w.]+)')
+
+
+def compiler_of(binary):
+    # GCC and Clang leave their version in the .comment section of ELF binaries
+    try:
+        with open(binary, 'rb') as f:
+            match = COMPILER_ID.search(f.read())
+    except OSError:
+        match = None
+    return match.group(1).decode() if match else 'unknown'
+
+
+def cpu_model():
+    try:
+        with open('/proc/cpuinfo') as f:
+            for line in f:
+                if line.startswith('model name'):
+                    return line.split(':', 1)[1].strip()
+    except OSError:
+        pass
+    if platform.system() == 'Darwin':
+        try:
+            return subprocess.check_output(['sysctl', '-n', 'machdep.cpu.brand_string'], text=True).strip()
+        except (OSError, subprocess.CalledProcessError):
+            pass
+    return platform.processor() or 'unknown'
+
+
+def metadata(binary, suite):
+    return {
+        'suite': suite,
+        'binary': os.path.basename(binary),
+        'compiler': compiler_of(binary),
+        'cpu': cpu_model(),
+        'machine': platform.node(),
+        'date': datetime.datetime.now().isoformat(timespec='seconds'),
+    }
+
+
+def record_catch2(binary, extra_args):
+    with tempfile.TemporaryDirectory() as tmp:
+        xml_path = os.path.join(tmp, 'results.xml')
+        run = subprocess.run([binary, '--reporter', 'xml', '--out', xml_path] + extra_args,
+                             stdout=subprocess.PIPE, text=True)
+        if run.returncode != 0:
+            sys.exit('%s failed with status %d' % (binary, run.returncode))
+        root = ET.parse(xml_path).getroot()
+
+    # Counter lines follow the benchmarks in order, so a name's n-th line belongs to its n-th result
+    counters = {}
+    for line in run.stdout.splitlines():
+        match = COUNTER_LINE.match(line)
+        if match:
+            values = {name: float(value) for value, name in COUNTER_VALUE.findall(match.group(2))}
+            counters.setdefault(match.group(1), []).append(values)
+
+    benchmarks = []
+    for test_case in root.iter('TestCase'):
+        for result in test_case.iter('BenchmarkResults'):
+            name = result.get('name')
+            pending = counters.get(name, [])
+            benchmarks.append({
+                'group': test_case.get('name'),
+                'name': name,
+                'mean': float(result.find('mean').get('value')),
+                'stddev': float(result.find('standardDeviation').get('value')),
+                'samples': int(result.get('samples')),
+                'counters': pending.pop(0) if pending else {},
+            })
+    return benchmarks
+
+
+def record_nanobench(binary):
+    with tempfile.TemporaryDirectory() as tmp:
+        report = os.path.join(tmp, 'nanobench.json')
+        if subprocess.run([binary, report], stdout=subprocess.DEVNULL).returncode != 0:
+            sys.exit('%s failed' % binary)
+        with open(report) as f:
+            results = json.load(f)['results']
+
+    benchmarks = []
+    for result in results:
+        # Measurements are seconds per iteration of the lambda, which covers batch operations
+        batch = float(result.get('batch', 1)) or 1.0
+        samples = [m['elapsed'] * 1e9 / batch for m in result['measurements']]
+        mean = sum(samples) / len(samples)
+        variance = sum((s - mean) ** 2 for s in samples) / max(len(samples) - 1, 1)
+        counters = {}
+        for key in ('cpucycles', 'instructions', 'branchinstructions', 'branchmisses'):
+            values = [m[key] / batch for m in result['measurements'] if key in m]
+            if values:
+                counters[key] = sum(values) / len(values)
+        benchmarks.append({
+            'group': result['title'],
+            'name': result['name'],
+            'mean': mean,
+            'stddev': math.sqrt(variance),
+            'samples': len(samples),
+            'counters': counters,
+        })
+    return benchmarks
+
+
+def incomplete_beta(a, b, x):
+    """Regularized incomplete beta function I_x(a, b), by continued fraction."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    if x > (a + 1.0) / (a + b + 2.0):
+        return 1.0 - incomplete_beta(b, a, 1.0 - x)
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) + a * math.log(x) + b * math.log(1.0 - x)) / a
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    result = d
+    for m in range(1, 300):
+        for numerator in (m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                          -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            result *= c * d
+        if abs(c * d - 1.0) < 1e-12:
+            break
+    return front * result
+
+
+def p_slower(baseline, current):
+    """One-sided Welch t-test p-value for current being slower than baseline."""
+    n1, n2 = baseline['samples'], current['samples']
+    if n1 < 2 or n2 < 2:
+        return 0.0 if current['mean'] > baseline['mean'] else 1.0
+    v1, v2 = baseline['stddev'] ** 2 / n1, current['stddev'] ** 2 / n2
+    if v1 + v2 == 0.0:
+        return 0.0 if current['mean'] > baseline['mean'] else 1.0
+    t = (current['mean'] - baseline['mean']) / math.sqrt(v1 + v2)
+    df = (v1 + v2) ** 2 / (v1 ** 2 / (n1 - 1) + v2 ** 2 / (n2 - 1))
+    tail = 0.5 * incomplete_beta(df / 2.0, 0.5, df / (df + t * t))
+    return tail if t > 0 else 1.0 - tail
+
+
+def compare(baseline_path, current_path, threshold, alpha):
+    with open(baseline_path) as f:
+        baseline = json.load(f)
+    with open(current_path) as f:
+        current = json.load(f)
+
+    for key in ('compiler', 'cpu'):
+        if baseline['meta'].get(key) != current['meta'].get(key):
+            print('note: %s differs, baseline %r, current %r' % (key, baseline['meta'].get(key),
+                                                                current['meta'].get(key)))
+
+    old = {(b['group'], b['name']): b for b in baseline['benchmarks']}
+    regressions = 0
+    print('%-60s %12s %12s %8s %8s' % ('benchmark', 'baseline ns', 'current ns', 'change', 'p'))
+    for bench in current['benchmarks']:
+        key = (bench['group'], bench['name'])
+        if key not in old:
+            print('%-60s %12s %12.3f  (new)' % (' / '.join(key)[:60], '-', bench['mean']))
+            continue
+        before = old.pop(key)
+        change = bench['mean'] / before['mean'] - 1.0 if before['mean'] > 0 else 0.0
+        p = p_slower(before, bench)
+        regressed = change > threshold and p < alpha
+        regressions += regressed
+        print('%-60s %12.3f %12.3f %+7.1f%% %8.4f%s' % (' / '.join(key)[:60], before['mean'], bench['mean'],
+                                                       change * 100, p, '  REGRESSION' if regressed else ''))
+    for key in old:
+        print('%-60s  (missing from current run)' % ' / '.join(key)[:60])
+
+    if regressions:
+        print('%d regression(s) beyond %.1f%% at p < %g' % (regressions, threshold * 100, alpha))
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n', 1)[0])
+    commands = parser.add_subparsers(dest='command', required=True)
+    catch2 = commands.add_parser('record-catch2')
+    catch2.add_argument('binary')
+    catch2.add_argument('output')
+    catch2.add_argument('catch2_args', nargs=argparse.REMAINDER)
+    nanobench = commands.add_parser('record-nanobench')
+    nanobench.add_argument('binary')
+    nanobench.add_argument('output')
+    comparison = commands.add_parser('compare')
+    comparison.add_argument('baseline')
+    comparison.add_argument('current')
+    comparison.add_argument('--threshold', type=float, default=0.05, help='relative slowdown, default 0.05')
+    comparison.add_argument('--alpha', type=float, default=0.01, help='significance level, default 0.01')
+    args = parser.parse_args()
+
+    if args.command == 'compare':
+        sys.exit(compare(args.baseline, args.current, args.threshold, args.alpha))
+
+    if args.command == 'record-catch2':
+        benchmarks = record_catch2(args.binary, args.catch2_args)
+        suite = 'catch2'
+    else:
+        benchmarks = record_nanobench(args.binary)
+        suite = 'nanobench'
+    directory = os.path.dirname(args.output)
+    if directory:
+        os.makedirs(directory, exist_ok=True)
+    with open(args.output, 'w') as f:
+        json.dump({'meta': metadata(args.binary, suite), 'benchmarks': benchmarks}, f, indent=2)
+    print('Wrote %d benchmarks to %s' % (len(benchmarks), args.output))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,117 @@
+"""Check the machine code of the expected64 accessors against fixed budgets.
+
+Usage: python3 codegen_audit.py FILE [--objdump PATH] [--llvm-mca PATH]
+
+FILE holds the probes of test/src/codegen_probes.cpp, compiled at -O2. Every
+has_error_*, get_value_*, get_error_*, make_error_* and set_error_* probe must
+fit its instruction budget (ret included, padding and endbr64 excluded) and may
+not contain conditional branches. With llvm-mca the block reciprocal throughput of each probe is
+reported as well. Exits with 1 on a violation and 77, which CTest treats as a
+skip, when objdump is missing or the target is neither x86-64 nor AArch64.
+"""
+import argparse
+import re
+import subprocess
+import sys
+
+from count_instructions import FUNCTION_HEADER, INSTRUCTION
+
+SKIP = 77
+
+# Instruction budget per accessor, the same for every encoding. int64 get_error needs 6 with GCC 12 and is the
+# tightest probe, so get_error has room for one or two extra moves from other compilers. make_error and set_error
+# need 4 and 5 with GCC 12; a counting or tracing call leaking into the disabled build fails them as calls out.
+BUDGETS = {'has_error': 5, 'get_value': 2, 'get_error': 8, 'make_error': 5, 'set_error': 6}
+ENCODINGS = ['int64', 'uint64', 'double', 'tagged_double', 'pointer']
+
+PADDING = re.compile(r'^(nop|xchg\s+%ax,%ax|data16|cs nop|endbr64|bti|int3|udf)')
+X86_CONDITIONAL = re.compile(r'^(j(?!mp)[a-z]+|loop[a-z]*)\b')
+ARM_CONDITIONAL = re.compile(r'^(b\.[a-z]+|cbn?z|tbn?z)\b')
+
+
+def disassemble(path, objdump):
+    output = subprocess.run([objdump, '-d', '--no-show-raw-insn', path],
+                            check=True, capture_output=True, text=True).stdout
+    arch = None
+    if re.search(r'x86-64|x86_64', output):
+        arch = 'x86-64'
+    elif re.search(r'aarch64|arm64', output):
+        arch = 'aarch64'
+    functions = {}
+    current = None
+    for line in output.splitlines():
+        header = FUNCTION_HEADER.match(line)
+        if header:
+            current = header.group(1).lstrip('_')  # Mach-O prefixes C names with an underscore
+            functions[current] = []
+            continue
+        instruction = INSTRUCTION.match(line)
+        if current is not None and instruction:
+            comment = '#' if arch == 'x86-64' else '//'  # AArch64 immediates start with '#'
+            text = re.sub(r'\s+', ' ', instruction.group(1).split(comment)[0]).strip()
+            if text and not PADDING.match(text):
+                functions[current].append(text)
+    return arch, functions
+
+
+def trim(instructions):
+    # Everything after the last return is alignment or unreachable
+    last_ret = max((i for i, text in enumerate(instructions) if text.split()[0] in ('ret', 'retq')), default=None)
+    return instructions if last_ret is None else instructions[:last_ret + 1]
+
+
+def throughput(llvm_mca, instructions):
+    if llvm_mca is None:
+        return None
+    body = '\n'.join(text for text in instructions if text.split()[0] not in ('ret', 'retq')) + '\n'
+    run = subprocess.run([llvm_mca], input=body, capture_output=True, text=True)
+    match = re.search(r'Block RThroughput:\s+([\d.]+)', run.stdout)
+    return float(match.group(1)) if run.returncode == 0 and match else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n', 1)[0])
+    parser.add_argument('file')
+    parser.add_argument('--objdump', default='objdump')
+    parser.add_argument('--llvm-mca', dest='llvm_mca')
+    args = parser.parse_args()
+
+    try:
+        arch, functions = disassemble(args.file, args.objdump)
+    except FileNotFoundError:
+        print('objdump not found, skipping')
+        sys.exit(SKIP)
+    if arch is None:
+        print('unsupported target, skipping')
+        sys.exit(SKIP)
+    conditional = X86_CONDITIONAL if arch == 'x86-64' else ARM_CONDITIONAL
+
+    failures = []
+    print('%-24s %12s %8s %10s' % ('probe', 'instructions', 'budget', 'rthroughput'))
+    for accessor, budget in BUDGETS.items():
+        for encoding in ENCODINGS:
+            name = '%s_%s' % (accessor, encoding)
+            if name not in functions:
+                failures.append('%s: probe missing' % name)
+                continue
+            instructions = trim(functions[name])
+            estimate = throughput(args.llvm_mca, instructions)
+            print('%-24s %12d %8d %10s' % (name, len(instructions), budget,
+                                           '-' if estimate is None else '%.2f' % estimate))
+            if len(instructions) > budget:
+                failures.append('%s: %d instructions, budget %d' % (name, len(instructions), budget))
+            branches = [text for text in functions[name] if conditional.match(text)]
+            if branches:
+                failures.append('%s: conditional branch %s' % (name, '; '.join(branches)))
+            if any(text.split()[0] in ('call', 'callq', 'bl', 'blr') for text in instructions):
+                failures.append('%s: calls out' % name)
+            if failures and failures[-1].startswith(name):
+                print('    ' + '\n    '.join(instructions))
+
+    for failure in failures:
+        print('FAIL ' + failure)
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,89 @@
+"""Count the instructions of selected functions in a binary or object file.
+
+Usage: python3 count_instructions.py FILE [REGEX]
+
+Disassembles FILE with objdump and prints one row per function whose demangled
+name matches REGEX (default: the callees and driver loops of the ABI benchmark).
+The stack column counts instructions touching %rsp/%rbp, which is where results
+returned through memory show up.
+"""
+import re
+import subprocess
+import sys
+
+DEFAULT_PATTERN = r'\b(abi_|drive_)'
+
+FUNCTION_HEADER = re.compile(r'^[0-9a-f]+ <(.+)>:$')
+INSTRUCTION = re.compile(r'^\s+[0-9a-f]+:\s+(\S.*)$')
+
+
+def short_name(name):
+    # Drop the return type and the parameter list, keep template arguments
+    name = name.replace('(anonymous namespace)::', '')
+    depth = 0
+    for i, c in enumerate(name):
+        if c == '<':
+            depth += 1
+        elif c == '>':
+            depth -= 1
+        elif c == '(' and depth == 0:
+            name = name[:i]
+            break
+    depth = 0
+    for i in range(len(name) - 1, -1, -1):
+        c = name[i]
+        if c == '>':
+            depth += 1
+        elif c == '<':
+            depth -= 1
+        elif c == ' ' and depth == 0:
+            return name[i + 1:]
+    return name
+
+
+def count_instructions(path, pattern):
+    output = subprocess.run(['objdump', '-d', '-C', '--no-show-raw-insn', path],
+                            check=True, capture_output=True, text=True).stdout
+    functions = {}
+    current = None
+    for line in output.splitlines():
+        header = FUNCTION_HEADER.match(line)
+        if header:
+            name = header.group(1)
+            current = short_name(name) if re.search(pattern, name) else None
+            if current is not None:
+                functions[current] = [0, 0]
+            continue
+        instruction = INSTRUCTION.match(line)
+        if current is not None and instruction:
+            text = instruction.group(1)
+            functions[current][0] += 1
+            if '%rsp' in text or '%rbp' in text:
+                functions[current][1] += 1
+    return functions
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print("Usage: python3 count_instructions.py FILE [REGEX]")
+        sys.exit(1)
+
+    pattern = sys.argv[2] if len(sys.argv) == 3 else DEFAULT_PATTERN
+    try:
+        functions = count_instructions(sys.argv[1], pattern)
+    except FileNotFoundError:
+        print("Error: objdump not found.")
+        sys.exit(1)
+    except subprocess.CalledProcessError as error:
+        print(f"Error: objdump failed: {error.stderr.strip()}")
+        sys.exit(1)
+
+    width = max([len(name) for name in functions] + [8])
+    print(f"{'function':<{width}} {'instructions':>12} {'stack':>6}")
+    for name in sorted(functions):
+        instructions, stack = functions[name]
+        print(f"{name:<{width}} {instructions:>12} {stack:>6}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,72 @@
+"""Compare the code size and compile time of expected64 and tl::expected.
+
+Usage: python3 footprint_report.py COMPILER SOURCE [--combinations N ...]
+                                   [-I DIR ...] [--flags FLAGS]
+
+Compiles SOURCE (benchmark/footprint.cpp) once per library and combination
+count, takes the best of three compile times, and reads the object file with
+nm: the number of functions and their .text bytes, in total and per function.
+"""
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+VARIANTS = [('expected64', []), ('tl::expected', ['-DFOOTPRINT_TL_EXPECTED'])]
+NM_LINE = re.compile(r'^(\d+) (\d+) ([tTwW]) (.*)$')
+
+
+def compile_once(command):
+    start = time.perf_counter()
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return time.perf_counter() - start
+
+
+def text_symbols(path):
+    output = subprocess.run(['nm', '-C', '--defined-only', '--print-size', '-t', 'd', path],
+                            check=True, capture_output=True, text=True).stdout
+    symbols = {}
+    for line in output.splitlines():
+        match = NM_LINE.match(line)
+        if match:
+            symbols[match.group(4)] = int(match.group(2))
+    return symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n', 1)[0])
+    parser.add_argument('compiler')
+    parser.add_argument('source')
+    parser.add_argument('--combinations', type=int, nargs='+', default=[16, 64, 256])
+    parser.add_argument('-I', dest='includes', action='append', default=[])
+    parser.add_argument('--flags', default='-std=c++20 -O2')
+    args = parser.parse_args()
+
+    print('%-13s %6s %10s %10s %12s %10s %10s' % ('library', 'N', 'compile s', 'functions', 'text bytes',
+                                                 'produce', 'consume'))
+    with tempfile.TemporaryDirectory() as tmp:
+        for combinations in args.combinations:
+            for name, defines in VARIANTS:
+                obj = os.path.join(tmp, 'footprint.o')
+                command = [args.compiler] + shlex.split(args.flags) + ['-I' + d for d in args.includes] + defines + [
+                    '-DFOOTPRINT_COMBINATIONS=%d' % combinations, '-c', args.source, '-o', obj]
+                try:
+                    seconds = min(compile_once(command) for _ in range(3))
+                    symbols = text_symbols(obj)
+                except (OSError, subprocess.CalledProcessError) as error:
+                    sys.exit('%s failed: %s' % (name, error))
+
+                # Average size of the producers and consumers, which is where the two libraries differ
+                produce = [size for symbol, size in symbols.items() if 'produce<' in symbol]
+                consume = [size for symbol, size in symbols.items() if 'consume<' in symbol]
+                print('%-13s %6d %10.2f %10d %12d %10.1f %10.1f' % (
+                    name, combinations, seconds, len(symbols), sum(symbols.values()),
+                    sum(produce) / max(len(produce), 1), sum(consume) / max(len(consume), 1)))
+
+
+if __name__ == '__main__':
+    main()
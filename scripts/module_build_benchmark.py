@@ -0,0 +1,132 @@
+"""Time a synthetic project that uses expected64 through the header and through the module.
+
+Usage: python3 module_build_benchmark.py [--units 500] [--cmake PATH]
+                                         [--compiler PATH] [--jobs N]
+
+Generates UNITS translation units, each with its own error enum and a few
+functions on expected64 and optional64, once with #include and once with
+import expected64, and builds each variant from scratch with CMake and Ninja.
+The module variant needs CMake 3.28 and a compiler with module scanning
+(GCC 14, Clang 16), otherwise only the header build is timed.
+"""
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+UNIT = '''{prologue}
+#include <cstdint>
+
+namespace unit{index}
+{{
+enum class error : uint8_t
+{{
+  invalid = 1,
+  overflow
+}};
+
+expected64<int64_t, error> parse(int64_t input)
+{{
+  if (input < 0)
+    return expected64<int64_t, error>(error::invalid);
+  if (input > {index} + 1000000)
+    return expected64<int64_t, error>(error::overflow);
+  return expected64<int64_t, error>(input * 3);
+}}
+
+optional64<double> ratio(int64_t a, int64_t b)
+{{
+  const auto x = parse(a);
+  const auto y = parse(b);
+  if (x.has_error() || y.has_error() || y.get_value() == 0)
+    return optional64<double>();
+  return optional64<double>(static_cast<double>(x.get_value()) / static_cast<double>(y.get_value()));
+}}
+}}  // namespace unit{index}
+
+int64_t entry{index}(int64_t input)
+{{
+  const auto r = unit{index}::ratio(input, {index} + 1);
+  return r.has_value() ? static_cast<int64_t>(*r) : -1;
+}}
+'''
+
+PROJECT = '''cmake_minimum_required(VERSION {cmake_minimum})
+project(expected64_build_benchmark LANGUAGES CXX)
+set(CMAKE_CXX_STANDARD 20)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+set(EXPECTED64_BUILD_MODULE {module})
+add_subdirectory("{repo}" expected64)
+file(GLOB units CONFIGURE_DEPENDS ${{CMAKE_SOURCE_DIR}}/units/*.cpp)
+add_library(units STATIC ${{units}})
+target_link_libraries(units PRIVATE {target})
+'''
+
+
+def cmake_version(cmake):
+    output = subprocess.run([cmake, '--version'], capture_output=True, text=True, check=True).stdout
+    return tuple(int(part) for part in re.search(r'(\d+)\.(\d+)', output).groups())
+
+
+def build(variant, args, root):
+    module = variant == 'module'
+    source = os.path.join(root, variant)
+    os.makedirs(os.path.join(source, 'units'))
+    if module:
+        prologue = 'import expected64;'
+    else:
+        prologue = '#include <expected64/expected64.hpp>\n#include <expected64/optional64.hpp>'
+    for index in range(args.units):
+        with open(os.path.join(source, 'units', 'unit%d.cpp' % index), 'w') as f:
+            f.write(UNIT.format(prologue=prologue, index=index))
+    with open(os.path.join(source, 'CMakeLists.txt'), 'w') as f:
+        f.write(PROJECT.format(cmake_minimum='3.28' if module else '3.14', module='ON' if module else 'OFF',
+                               repo=REPO.replace('\\', '/'), target='expected64::module' if module
+                               else 'expected64::expected64'))
+
+    binary = os.path.join(root, variant + '-build')
+    configure = [args.cmake, '-S', source, '-B', binary, '-G', 'Ninja', '-DCMAKE_BUILD_TYPE=Release']
+    if args.compiler:
+        configure.append('-DCMAKE_CXX_COMPILER=' + args.compiler)
+    if subprocess.run(configure, stdout=subprocess.DEVNULL).returncode != 0:
+        return None
+    start = time.perf_counter()
+    if subprocess.run([args.cmake, '--build', binary, '-j', str(args.jobs)], stdout=subprocess.DEVNULL).returncode != 0:
+        return None
+    return time.perf_counter() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n', 1)[0])
+    parser.add_argument('--units', type=int, default=500)
+    parser.add_argument('--cmake', default='cmake')
+    parser.add_argument('--compiler')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count() or 1)
+    args = parser.parse_args()
+
+    if shutil.which('ninja') is None:
+        sys.exit('ninja is required')
+    variants = ['header']
+    if cmake_version(args.cmake) >= (3, 28):
+        variants.append('module')
+    else:
+        print('CMake is older than 3.28, timing the header build only')
+
+    with tempfile.TemporaryDirectory() as root:
+        for variant in variants:
+            seconds = build(variant, args, root)
+            if seconds is None:
+                print('%-7s build failed' % variant)
+            else:
+                print('%-7s %4d units %8.2f s %8.1f ms/unit' % (variant, args.units, seconds,
+                                                               seconds * 1000 / args.units))
+
+
+if __name__ == '__main__':
+    main()
@@ -5,13 +5,14 @@ def parse_benchmark_output(output):
     # Updated regex pattern to capture different parts of the benchmark output
     # This pattern may need further refinement based on the actual format of your raw results
     test_pattern = r'-------------------------------------------------------------------------------\n(.*?)\n-------------------------------------------------------------------------------\n(.*?)\n==============================================================================='
-    benchmark_pattern = r'(\w+ with [\w\:\:]+|Factorial with Raw Type|Cube with Raw Type)\s+(\d+)\s+(\d+)\s+([\d\.]+ ms)\s+([\d\.]+ ns)\s+([\d\.]+ ns)\s+([\d\.]+ ns)\s+([\d\.]+ ns)\s+([\d\.]+ ns)\s+([\d\.]+ ns)'
+    # Any name followed by the sample and iteration counts, e.g. "expected64, branchy [1% bursty]"
+    benchmark_pattern = r'^(\S[^\n]*?)\s+(\d+)\s+(\d+)\s+([\d\.]+ \w?s)\s+([\d\.]+ \w?s)\s+([\d\.]+ \w?s)\s+([\d\.]+ \w?s)\s+([\d\.]+ \w?s)\s+([\d\.]+ \w?s)\s+([\d\.]+ \w?s)'
 
     tests = re.findall(test_pattern, output, re.DOTALL)
     parsed_data = {}
 
     for test_name, test_content in tests:
-        benchmarks = re.findall(benchmark_pattern, test_content)
+        benchmarks = re.findall(benchmark_pattern, test_content, re.MULTILINE)
         parsed_data[test_name.strip()] = benchmarks
 
     return parsed_data
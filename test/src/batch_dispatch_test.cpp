@@ -0,0 +1,220 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "expected64/batch_dispatch.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+static const batch_backend all_backends[] = {
+    batch_backend::scalar, batch_backend::avx2, batch_backend::avx512, batch_backend::simd};
+
+// Values, errors, reserved words and arbitrary bit patterns, in random order
+template<typename Result>
+static std::vector<uint64_t> gen_words(size_t n, bool with_errors)
+{
+  using T = typename Result::value_type;
+  std::mt19937_64                    rng(12345);
+  std::uniform_int_distribution<int> kind(0, with_errors ? 5 : 2);
+  std::uniform_int_distribution<int> small(-1000, 1000);
+  static const int64_t               target = 0;
+  std::vector<uint64_t>              words(n);
+  for (auto& word : words) {
+    switch (kind(rng)) {
+      case 0:
+      case 1:
+        if constexpr (std::is_same_v<T, double>) {
+          word = Result(small(rng) * 0.25).to_bits();
+        } else if constexpr (std::is_pointer_v<T>) {
+          word = Result(&target).to_bits();
+        } else {
+          word = Result(static_cast<T>(small(rng))).to_bits();
+        }
+        break;
+      case 2:
+        if constexpr (std::is_same_v<typename Result::policy_type, tagged_nan_policy>) {
+          const double nan = std::numeric_limits<double>::quiet_NaN();
+          word = Result(small(rng) < 0 ? -nan : nan).to_bits();  // Values under this policy
+        } else if constexpr (std::is_same_v<T, double>) {
+          word = Result(small(rng) < 0 ? -std::numeric_limits<double>::infinity() : 1e300).to_bits();
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+          word = Result(small(rng) < 0 ? -(INT64_C(1) << 62) : (INT64_C(1) << 62) - 1).to_bits();
+        } else {
+          word = std::is_pointer_v<T> ? 0 : ~0ULL >> 1;  // nullptr, largest uint64_t value
+        }
+        break;
+      case 3:
+        word = Result(small(rng) < 0 ? error_code::misc_error : error_code::no_error).to_bits();
+        break;
+      case 4:
+        word = Result::reserved(static_cast<uint32_t>(rng() % 16)).to_bits();
+        break;
+      default:
+        word = rng();
+    }
+  }
+  return words;
+}
+
+static const size_t lengths[] = {0, 1, 3, 7, 8, 9, 31, 63, 64, 65, 127, 130, 1000};
+
+template<typename Result>
+static void check_backend(batch_backend backend)
+{
+  const auto& scalar = batch_kernels<Result>(batch_backend::scalar);
+  const auto& kernels = batch_kernels<Result>(backend);
+
+  for (const bool with_errors : {false, true}) {
+    const auto all = gen_words<Result>(1001, with_errors);
+    for (const size_t offset : {size_t {0}, size_t {1}}) {
+      for (const size_t n : lengths) {
+        const uint64_t* words = all.data() + offset;
+        const size_t    bit_words = (n + 63) / 64;
+        CAPTURE(batch_backend_name(backend), with_errors, offset, n);
+
+        // Error bits, against has_error() as well as scalar
+        std::vector<uint64_t> expected_bits(bit_words, ~0ULL);
+        std::vector<uint64_t> bits(bit_words, ~0ULL);
+        const size_t          errors = scalar.error_bits(words, n, expected_bits.data());
+        REQUIRE(kernels.error_bits(words, n, bits.data()) == errors);
+        REQUIRE(bits == expected_bits);
+        size_t reference_errors = 0;
+        for (size_t i = 0; i < n; ++i) {
+          const bool error = Result::from_bits(words[i]).has_error();
+          reference_errors += error;
+          REQUIRE(((bits[i / 64] >> (i % 64)) & 1) == static_cast<uint64_t>(error));
+        }
+        REQUIRE(errors == reference_errors);
+
+        std::vector<uint64_t> expected_out(n + 1, 0);
+        std::vector<uint64_t> out(n + 1, 0);
+        const size_t          kept = scalar.compact(words, n, expected_out.data());
+        REQUIRE(kept == n - errors);
+        REQUIRE(kernels.compact(words, n, out.data()) == kept);
+        REQUIRE(std::memcmp(out.data(), expected_out.data(), kept * sizeof(uint64_t)) == 0);
+        REQUIRE(out[n] == 0);
+
+        std::vector<uint64_t> expected_values(n), expected_payloads(n), values(n), payloads(n);
+        REQUIRE(scalar.decode(words, n, expected_values.data(), expected_payloads.data(), expected_bits.data())
+                == errors);
+        REQUIRE(kernels.decode(words, n, values.data(), payloads.data(), bits.data()) == errors);
+        REQUIRE(values == expected_values);
+        REQUIRE(payloads == expected_payloads);
+        REQUIRE(bits == expected_bits);
+
+        // Valid words and the errors set_error() creates come back unchanged
+        std::vector<uint64_t> expected_encoded(n), encoded(n);
+        scalar.encode(values.data(), payloads.data(), bits.data(), n, expected_encoded.data());
+        kernels.encode(values.data(), payloads.data(), bits.data(), n, encoded.data());
+        REQUIRE(encoded == expected_encoded);
+        for (size_t i = 0; i < n; ++i) {
+          if (Result::error_payload(words[i]) <= static_cast<uint64_t>(error_code::misc_error)) {
+            REQUIRE(encoded[i] == words[i]);
+          }
+        }
+
+        if constexpr (std::is_same_v<typename Result::policy_type, tagged_nan_policy>) {
+          // IEEE 754 leaves open which NaN operand an addition returns, so sums of genuine NaNs only agree on being NaN
+          const auto check_sum = [&](const uint64_t* begin, size_t size)
+          {
+            const Result expected_sum = scalar.sum(begin, size);
+            const Result sum = kernels.sum(begin, size);
+            if (!expected_sum.has_error() && std::isnan(expected_sum.get_value())) {
+              REQUIRE(!sum.has_error());
+              REQUIRE(std::isnan(sum.get_value()));
+            } else {
+              REQUIRE(sum.to_bits() == expected_sum.to_bits());
+            }
+          };
+          check_sum(words, n);
+          check_sum(out.data(), kept);
+        } else if constexpr (!std::is_pointer_v<typename Result::value_type>) {
+          REQUIRE(kernels.sum(words, n).to_bits() == scalar.sum(words, n).to_bits());
+          REQUIRE(kernels.sum(out.data(), kept).to_bits() == scalar.sum(out.data(), kept).to_bits());
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Every batch backend matches the scalar reference")
+{
+  for (const batch_backend backend : all_backends) {
+    if (!batch_backend_supported(backend)) {
+      WARN(batch_backend_name(backend) << " is not supported here, skipped");
+      continue;
+    }
+    check_backend<expected64<int64_t, error_code>>(backend);
+    check_backend<expected64<uint64_t, error_code>>(backend);
+    check_backend<expected64<double, error_code>>(backend);
+    check_backend<expected64<double, error_code, tagged_nan_policy>>(backend);
+    check_backend<expected64<const int64_t*, error_code>>(backend);
+  }
+}
+
+TEST_CASE("batch_sum")
+{
+  using r = expected64<int64_t, error_code>;
+  std::vector<uint64_t> words;
+  for (int64_t i = 1; i <= 100; ++i) {
+    words.push_back(r(i).to_bits());
+  }
+  REQUIRE(batch_sum<r>(words.data(), words.size()).get_value() == 5050);
+  REQUIRE(batch_sum<r>(words.data(), 0).get_value() == 0);
+
+  words[41] = r(error_code::calculation_error).to_bits();
+  words[77] = r(error_code::misc_error).to_bits();
+  const auto first = batch_sum<r>(words.data(), words.size());
+  REQUIRE(first.has_error());
+  REQUIRE(first.get_error() == error_code::calculation_error);
+
+  using d = expected64<double, error_code>;
+  const uint64_t halves[] = {d(0.5).to_bits(), d(1.5).to_bits(), d(-0.25).to_bits()};
+  REQUIRE(batch_sum<d>(halves, 3).to_bits() == d(1.75).to_bits());
+}
+
+TEST_CASE("batch_encode inverts batch_decode")
+{
+  using r = expected64<uint64_t, error_code>;
+  const uint64_t words[] = {r(7UL).to_bits(), r(error_code::misc_error).to_bits(), r(0UL).to_bits()};
+  uint64_t       values[3], payloads[3], bits[1], encoded[3];
+  REQUIRE(batch_decode<r>(words, 3, values, payloads, bits) == 1);
+  REQUIRE(values[0] == 7);
+  REQUIRE(values[1] == 0);
+  REQUIRE(payloads[1] == static_cast<uint64_t>(error_code::misc_error));
+  REQUIRE(bits[0] == 0b010);
+  batch_encode<r>(values, payloads, bits, 3, encoded);
+  REQUIRE(std::memcmp(encoded, words, sizeof(words)) == 0);
+
+  uint64_t kept[3];
+  REQUIRE(batch_compact<r>(words, 3, kept) == 2);
+  REQUIRE(kept[1] == r(0UL).to_bits());
+  REQUIRE(batch_error_bits<r>(words, 3, bits) == 1);
+}
+
+// CTest runs this once per EXPECTED64_BATCH_BACKEND value
+TEST_CASE("EXPECTED64_BATCH_BACKEND selects a supported backend", "[active]")
+{
+  const batch_backend active = active_batch_backend();
+  REQUIRE(batch_backend_supported(active));
+  const char* requested = std::getenv("EXPECTED64_BATCH_BACKEND");
+  for (const batch_backend backend : all_backends) {
+    if (requested != nullptr && std::strcmp(requested, batch_backend_name(backend)) == 0) {
+      REQUIRE((active == backend || !batch_backend_supported(backend)));
+    }
+    if (requested == nullptr && batch_backend_supported(backend)) {
+      REQUIRE(active >= backend);
+    }
+  }
+}
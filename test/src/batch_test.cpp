@@ -0,0 +1,100 @@
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "expected64/batch.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+template<typename T>
+static uint64_t reference_mask(const std::array<expected64<T, error_code>, 8>& results)
+{
+  uint64_t mask = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    mask |= static_cast<uint64_t>(results[i].has_error()) << i;
+  }
+  return mask;
+}
+
+template<typename T>
+static std::array<uint64_t, 8> to_words(const std::array<expected64<T, error_code>, 8>& results)
+{
+  std::array<uint64_t, 8> words {};
+  for (size_t i = 0; i < results.size(); ++i) {
+    words[i] = results[i].to_bits();
+  }
+  return words;
+}
+
+TEST_CASE("batch_error_mask matches has_error")
+{
+  using e = error_code;
+
+  SECTION("int64_t")
+  {
+    using r = expected64<int64_t, e>;
+    const std::array<r, 8> results {r(0L), r(e::misc_error), r(-1L), r(e::calculation_error), r(INT64_C(1) << 61),
+                                    r(-(INT64_C(1) << 61)), r(42L), r(e::no_error)};
+    const auto             words = to_words(results);
+    REQUIRE(batch_error_mask<r>(words.data(), words.size()) == reference_mask(results));
+    REQUIRE(batch_error_mask<r>(words.data(), words.size()) == 0b1000'1010);
+  }
+
+  SECTION("double")
+  {
+    using r = expected64<double, e>;
+    const std::array<r, 8> results {r(0.0),
+                                    r(-0.0),
+                                    r(e::misc_error),
+                                    r(std::numeric_limits<double>::infinity()),
+                                    r(-std::numeric_limits<double>::infinity()),
+                                    r(std::numeric_limits<double>::quiet_NaN()),
+                                    r(1e300),
+                                    r(e::no_error)};
+    const auto             words = to_words(results);
+    REQUIRE(batch_error_mask<r>(words.data(), words.size()) == reference_mask(results));
+    REQUIRE(batch_error_mask<r>(words.data(), words.size()) == 0b1010'0100);
+  }
+
+  SECTION("uint64_t and pointers")
+  {
+    using u = expected64<uint64_t, e>;
+    const std::array<u, 8> results {u(0UL), u(e::misc_error), u(~0UL >> 1), u(1UL), u(2UL), u(3UL), u(e::no_error),
+                                    u(4UL)};
+    const auto             words = to_words(results);
+    REQUIRE(batch_error_mask<u>(words.data(), words.size()) == reference_mask(results));
+
+    using p = expected64<const int*, e>;
+    static const int value = 0;
+    const p          ok(&value);
+    const p          failed(e::misc_error);
+    const uint64_t   pointer_words[] = {ok.to_bits(), failed.to_bits(), ok.to_bits()};
+    REQUIRE(batch_error_mask<p>(pointer_words, 3) == 0b010);
+  }
+
+  SECTION("Partial batches ignore the rest")
+  {
+    using r = expected64<uint64_t, e>;
+    const uint64_t words[] = {r(e::misc_error).to_bits(), 0, r(e::misc_error).to_bits()};
+    REQUIRE(batch_error_mask<r>(words, 2) == 0b01);
+    REQUIRE(batch_error_mask<r>(words, 0) == 0);
+  }
+}
+
+TEST_CASE("batch_equal_mask")
+{
+  std::array<uint64_t, 64> words {};
+  words[0] = 7;
+  words[9] = 7;
+  words[63] = 7;
+  REQUIRE(batch_equal_mask(words.data(), words.size(), 7) == ((1ULL << 63) | (1ULL << 9) | 1ULL));
+  REQUIRE(batch_equal_mask(words.data(), 8, 7) == 1);
+  REQUIRE(batch_equal_mask(words.data(), 8, 5) == 0);
+}
@@ -0,0 +1,39 @@
+// Probe functions for scripts/codegen_audit.py: one per accessor and encoding, with C linkage so the script finds
+// them by name. Compiled at -O2 into a library that is only disassembled, never linked. The error constructor and
+// set_error() probes are built without EXPECTED64_ERROR_COUNTERS and EXPECTED64_ERROR_TRACE, so they pin the disabled
+// path to plain stores.
+#include <cstdint>
+
+#include <expected64/expected64.hpp>
+
+enum class probe_error : uint32_t
+{
+};
+
+#define EXPECTED64_CODEGEN_PROBES(T, Policy, suffix) \
+  extern "C" bool has_error_##suffix(expected64<T, probe_error, Policy> result) \
+  { \
+    return result.has_error(); \
+  } \
+  extern "C" T get_value_##suffix(expected64<T, probe_error, Policy> result) \
+  { \
+    return result.get_value(); \
+  } \
+  extern "C" probe_error get_error_##suffix(expected64<T, probe_error, Policy> result) \
+  { \
+    return result.get_error(); \
+  } \
+  extern "C" expected64<T, probe_error, Policy> make_error_##suffix(probe_error error) \
+  { \
+    return expected64<T, probe_error, Policy>(error); \
+  } \
+  extern "C" void set_error_##suffix(expected64<T, probe_error, Policy>* result, probe_error error) \
+  { \
+    result->set_error(error); \
+  }
+
+EXPECTED64_CODEGEN_PROBES(int64_t, any_nan_policy, int64)
+EXPECTED64_CODEGEN_PROBES(uint64_t, any_nan_policy, uint64)
+EXPECTED64_CODEGEN_PROBES(double, any_nan_policy, double)
+EXPECTED64_CODEGEN_PROBES(double, tagged_nan_policy, tagged_double)
+EXPECTED64_CODEGEN_PROBES(const int64_t*, any_nan_policy, pointer)
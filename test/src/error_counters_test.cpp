@@ -0,0 +1,114 @@
+// Built with EXPECTED64_ERROR_COUNTERS, see test/CMakeLists.txt
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "expected64/expected64.hpp"
+#include "expected64/optional64.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+using result = expected64<int64_t, error_code>;
+
+namespace
+{
+// Errors with code created inside function
+uint64_t count_in(const error_counters_snapshot& snapshot, const char* function, error_code code)
+{
+  uint64_t total = 0;
+  for (const error_count& entry : snapshot.counts) {
+    if (entry.code == static_cast<uint64_t>(code) && std::strstr(entry.location.function_name(), function) != nullptr) {
+      total += entry.count;
+    }
+  }
+  return total;
+}
+
+result checked_divide(int64_t a, int64_t b)
+{
+  if (b == 0) {
+    return result(error_code::calculation_error);
+  }
+  return result(a / b);
+}
+
+void invalidate(result& r)
+{
+  r.set_error(error_code::misc_error);
+}
+}  // namespace
+
+TEST_CASE("Errors are counted per call site and code")
+{
+  const error_counters_snapshot before = snapshot_error_counters();
+
+  for (int64_t i = 0; i < 100; ++i) {
+    (void)checked_divide(10, i % 4);
+  }
+  result r(int64_t {1});
+  invalidate(r);
+
+  const error_counters_snapshot after = snapshot_error_counters();
+  REQUIRE(count_in(after, "checked_divide", error_code::calculation_error)
+          == count_in(before, "checked_divide", error_code::calculation_error) + 25);
+  REQUIRE(count_in(after, "invalidate", error_code::misc_error) == 1);
+  REQUIRE(count_in(after, "checked_divide", error_code::misc_error) == 0);
+  REQUIRE(after.dropped == 0);
+  REQUIRE(after.counts.front().count >= after.counts.back().count);
+}
+
+TEST_CASE("Values, optional64 and raw words are not counted")
+{
+  const error_counters_snapshot before = snapshot_error_counters();
+  optional64<int64_t>           empty;
+  empty.reset();
+  (void)result::from_bits(result::error_bits(error_code::misc_error));
+  (void)result::reserved(0);
+  (void)result(int64_t {5});
+  const error_counters_snapshot after = snapshot_error_counters();
+
+  uint64_t total_before = 0;
+  uint64_t total_after = 0;
+  for (const error_count& entry : before.counts) {
+    total_before += entry.count;
+  }
+  for (const error_count& entry : after.counts) {
+    total_after += entry.count;
+  }
+  REQUIRE(total_after == total_before);
+}
+
+TEST_CASE("Counts of other threads, live or exited, are merged")
+{
+  const uint64_t before = count_in(snapshot_error_counters(), "checked_divide", error_code::calculation_error);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back(
+        []
+        {
+          for (int i = 0; i < 1000; ++i) {
+            (void)checked_divide(1, 0);
+          }
+        });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const error_counters_snapshot snapshot = snapshot_error_counters();
+  REQUIRE(count_in(snapshot, "checked_divide", error_code::calculation_error) == before + 4000);
+
+  // Merging combines entries for the same site and keeps the rest
+  error_counters_snapshot combined = snapshot;
+  combined.merge(snapshot);
+  REQUIRE(combined.counts.size() == snapshot.counts.size());
+  REQUIRE(count_in(combined, "checked_divide", error_code::calculation_error) == 2 * (before + 4000));
+}
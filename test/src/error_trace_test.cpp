@@ -0,0 +1,91 @@
+// Built with EXPECTED64_ERROR_TRACE and EXPECTED64_ERROR_TRACE_FRAMES=8, see test/CMakeLists.txt
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+#include "expected64/expected64.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+using result = expected64<int64_t, error_code>;
+using double_result = expected64<double, error_code>;
+
+namespace
+{
+uint32_t origin_line = 0;
+
+result fail_deep()
+{
+  origin_line = __LINE__ + 1;
+  return result(error_code::misc_error);
+}
+
+double_result fail_double()
+{
+  double_result d(1.0);
+  d.set_error(error_code::calculation_error);
+  return d;
+}
+
+result layer(int depth)
+{
+  return depth == 0 ? fail_deep() : layer(depth - 1);
+}
+
+bool made_in(const std::optional<error_origin>& origin, const char* function)
+{
+  return origin.has_value() && std::strstr(origin->location.function_name(), function) != nullptr;
+}
+}  // namespace
+
+TEST_CASE("Errors carry their origin")
+{
+  static_assert(sizeof(result) == 8);
+
+  const result r = layer(5);
+  REQUIRE(r.has_error());
+  REQUIRE(r.get_error() == error_code::misc_error);
+
+  const auto origin = r.get_error_origin();
+  REQUIRE(made_in(origin, "fail_deep"));
+  REQUIRE(origin->location.line() == origin_line);
+  REQUIRE(origin->code == static_cast<uint64_t>(error_code::misc_error));
+  REQUIRE(origin->frame_count > 0);
+  REQUIRE(origin->frame_count <= 8);
+
+  const double_result d = fail_double();
+  REQUIRE(d.has_error());
+  REQUIRE(d.get_error() == error_code::calculation_error);
+  REQUIRE(made_in(d.get_error_origin(), "fail_double"));
+}
+
+TEST_CASE("Values and untraced errors have no origin")
+{
+  REQUIRE(!result(int64_t {3}).get_error_origin().has_value());
+  REQUIRE(!result::from_bits(result::error_bits(error_code::misc_error)).get_error_origin().has_value());
+  REQUIRE(!result::reserved(0).get_error_origin().has_value());
+}
+
+TEST_CASE("Reused ring entries are detected")
+{
+  const result old = layer(0);
+  for (int i = 0; i < 2048; ++i) {
+    (void)result(error_code::calculation_error);
+  }
+  REQUIRE(!old.get_error_origin().has_value());
+}
+
+TEST_CASE("Origins can be read from other threads")
+{
+  std::optional<result> from_thread;
+  std::thread([&] { from_thread = layer(2); }).join();
+  REQUIRE(made_in(from_thread->get_error_origin(), "fail_deep"));
+}
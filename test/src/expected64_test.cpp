@@ -1,4 +1,7 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include <bit>
+#include <cmath>
+
 #include "expected64/expected64.hpp"
 
 #include <catch2/catch_all.hpp>
@@ -543,3 +546,43 @@ TEST_CASE("Error Handling and Overflows")
     REQUIRE(result.get_error() == error_code::calculation_error);
   }
 }
+
+TEST_CASE("error_bits matches set_error")
+{
+  REQUIRE(expected64<int64_t, error_code>::error_bits(error_code::misc_error)
+          == expected64<int64_t, error_code>(error_code::misc_error).to_bits());
+  REQUIRE(expected64<uint64_t, error_code>::error_bits(error_code::misc_error)
+          == expected64<uint64_t, error_code>(error_code::misc_error).to_bits());
+  REQUIRE(expected64<double, error_code>::error_bits(error_code::misc_error)
+          == expected64<double, error_code>(error_code::misc_error).to_bits());
+  REQUIRE(expected64<int*, error_code>::error_bits(error_code::misc_error)
+          == expected64<int*, error_code>(error_code::misc_error).to_bits());
+}
+
+TEST_CASE("tagged_nan_policy keeps genuine NaNs as values")
+{
+  using result = expected64<double, error_code, tagged_nan_policy>;
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  for (const double value : {nan, -nan, std::numeric_limits<double>::signaling_NaN(), 0.0 / 0.0, 1.5}) {
+    const result r(value);
+    REQUIRE(!r.has_error());
+    REQUIRE(result::error_msb(r.to_bits()) == 0);
+    REQUIRE(r.to_bits() == std::bit_cast<uint64_t>(value));
+  }
+  // Any other NaN payload is a value too, including one an any_nan_policy error would have
+  REQUIRE(!result::from_bits(expected64<double, error_code>::error_bits(error_code::misc_error)).has_error());
+  REQUIRE(!result::from_bits(0xFFFF'0000'0000'0002).has_error());
+
+  const result error(error_code::misc_error);
+  REQUIRE(error.has_error());
+  REQUIRE(std::isnan(error.get_value()));
+  REQUIRE(error.get_error() == error_code::misc_error);
+  REQUIRE(result::error_bits(error_code::misc_error) == error.to_bits());
+  REQUIRE(result::error_msb(error.to_bits()) == 1ULL << 63);
+  REQUIRE(result::error_payload(error.to_bits()) == static_cast<uint64_t>(error_code::misc_error));
+
+  const result reserved = result::reserved(3);
+  REQUIRE(reserved.has_error());
+  REQUIRE(result::error_payload(reserved.to_bits()) == static_cast<uint64_t>(0xFFFF - 3) << 32);
+}
@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+#include "expected64/flat_map.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("expected64_flat_map basics")
+{
+  expected64_flat_map<int64_t, double> map;
+  REQUIRE(map.empty());
+  REQUIRE(map.capacity() == 8);
+  REQUIRE(!map.find(1).has_value());
+
+  REQUIRE(map.insert_or_assign(1, 1.5));
+  REQUIRE(map.insert_or_assign(0, 0.0));  // Key and value 0 are ordinary entries
+  REQUIRE(map.insert_or_assign(-3, -2.5));
+  REQUIRE(map.size() == 3);
+  REQUIRE(*map.find(1) > 1.4);
+  REQUIRE(map.find(0).has_value());
+  REQUIRE(*map.find(-3) < -2.4);
+  REQUIRE(!map.contains(2));
+
+  REQUIRE(map.insert_or_assign(1, 3.5));
+  REQUIRE(*map.find(1) > 3.4);
+  REQUIRE(map.size() == 3);
+
+  REQUIRE(map.erase(1));
+  REQUIRE(!map.erase(1));
+  REQUIRE(!map.contains(1));
+  REQUIRE(map.size() == 2);
+
+  map.clear();
+  REQUIRE(map.empty());
+  REQUIRE(!map.contains(0));
+}
+
+TEST_CASE("expected64_flat_map rejects values in the error encoding")
+{
+  expected64_flat_map<int64_t, double> doubles;
+  REQUIRE(!doubles.insert_or_assign(1, std::numeric_limits<double>::quiet_NaN()));
+  REQUIRE(doubles.insert_or_assign(1, std::numeric_limits<double>::infinity()));
+
+  expected64_flat_map<uint64_t, uint64_t> unsigned_values;
+  REQUIRE(!unsigned_values.insert_or_assign(1, ~0ULL));
+  REQUIRE(unsigned_values.insert_or_assign(1, ~0ULL >> 1));
+  REQUIRE(unsigned_values.size() == 1);
+}
+
+TEST_CASE("expected64_flat_map matches std::unordered_map")
+{
+  expected64_flat_map<uint64_t, int64_t> map;
+  std::unordered_map<uint64_t, int64_t>  reference;
+  std::mt19937_64                        rng(12345);
+
+  // Small key range so inserts, overwrites and erases of the same keys interleave and leave deleted slots behind
+  for (int i = 0; i < 200'000; ++i) {
+    const uint64_t key = rng() % 5000;
+    const auto     value = static_cast<int64_t>(rng() % 1'000'000) - 500'000;
+    if (rng() % 3 == 0) {
+      REQUIRE(map.erase(key) == (reference.erase(key) == 1));
+    } else {
+      REQUIRE(map.insert_or_assign(key, value));
+      reference[key] = value;
+    }
+  }
+  REQUIRE(map.size() == reference.size());
+  for (uint64_t key = 0; key < 5000; ++key) {
+    const auto it = reference.find(key);
+    const auto found = map.find(key);
+    REQUIRE(found.has_value() == (it != reference.end()));
+    if (found.has_value()) {
+      REQUIRE(*found == it->second);
+    }
+  }
+
+  size_t visited = 0;
+  map.for_each(
+      [&](uint64_t key, int64_t value)
+      {
+        REQUIRE(reference.at(key) == value);
+        ++visited;
+      });
+  REQUIRE(visited == reference.size());
+}
+
+TEST_CASE("expected64_flat_map reserve and growth")
+{
+  expected64_flat_map<int64_t, int64_t> map(1000);
+  const size_t                          reserved_capacity = map.capacity();
+  REQUIRE(reserved_capacity * 7 / 8 >= 1000);
+  for (int64_t key = 0; key < 1000; ++key) {
+    REQUIRE(map.insert_or_assign(key * 7919, key));
+  }
+  REQUIRE(map.capacity() == reserved_capacity);
+
+  map.reserve(100'000);
+  REQUIRE(map.capacity() >= 100'000);
+  for (int64_t key = 0; key < 1000; ++key) {
+    REQUIRE(*map.find(key * 7919) == key);
+  }
+}
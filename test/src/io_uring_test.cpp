@@ -0,0 +1,167 @@
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "expected64/io_uring.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+struct temp_file
+{
+  std::filesystem::path path;
+  int                   fd;
+
+  explicit temp_file(const std::string& name)
+      : path(std::filesystem::temp_directory_path() / (name + "-" + std::to_string(::getpid()) + ".io"))
+      , fd(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))
+  {
+  }
+
+  ~temp_file()
+  {
+    ::close(fd);
+    std::filesystem::remove(path);
+  }
+};
+
+// Null where the kernel or a seccomp filter doesn't allow io_uring
+std::unique_ptr<io_uring_queue> try_queue(unsigned entries)
+{
+  try {
+    return std::make_unique<io_uring_queue>(entries);
+  } catch (const std::system_error& e) {
+    WARN("io_uring is not available here, skipped: " << e.what());
+    return nullptr;
+  }
+}
+
+// Submits everything queued and reaps exactly count completions
+std::vector<io_completion> run(io_uring_queue& queue, size_t count)
+{
+  const io_result submitted = queue.submit(static_cast<unsigned>(count));
+  REQUIRE(!submitted.has_error());
+  std::vector<io_completion> completions(count);
+  size_t                     reaped = 0;
+  while (reaped < count) {
+    reaped += queue.reap(std::span<io_completion>(completions).subspan(reaped));
+    if (reaped < count) {
+      REQUIRE(!queue.submit(static_cast<unsigned>(count - reaped)).has_error());
+    }
+  }
+  return completions;
+}
+}  // namespace
+
+TEST_CASE("cqe_result keeps counts and turns -errno into the error")
+{
+  for (const int32_t count : {0, 1, 4096, INT32_MAX}) {
+    const io_result result = cqe_result(count);
+    REQUIRE(!result.has_error());
+    REQUIRE(result.get_value() == count);
+  }
+  for (const int errno_value : {EPERM, ENOENT, EBADF, EAGAIN, EINVAL, ECANCELED, 4095}) {
+    const io_result result = cqe_result(-errno_value);
+    REQUIRE(result.has_error());
+    REQUIRE(result.get_error() == static_cast<std::errc>(errno_value));
+    REQUIRE(result.to_bits() == io_result(static_cast<std::errc>(errno_value)).to_bits());
+  }
+
+  io_uring_cqe cqes[3] {};
+  cqes[0] = io_uring_cqe {7, 512, 0};
+  cqes[1] = io_uring_cqe {8, -EIO, 0};
+  cqes[2] = io_uring_cqe {9, 0, 0};
+  io_completion out[3];
+  cqe_results(cqes, out);
+  REQUIRE(out[0].user_data == 7);
+  REQUIRE(out[0].result.get_value() == 512);
+  REQUIRE(out[1].user_data == 8);
+  REQUIRE(out[1].result.get_error() == std::errc::io_error);
+  REQUIRE(out[2].result.get_value() == 0);
+}
+
+TEST_CASE("io_uring_queue writes and reads back a local file")
+{
+  auto queue = try_queue(8);
+  if (!queue) {
+    return;
+  }
+  REQUIRE(queue->capacity() == 8);
+  temp_file file("io_uring");
+  REQUIRE(file.fd >= 0);
+
+  const std::string first = "expected64 over io_uring\n";
+  const std::string second = "second block\n";
+  REQUIRE(queue->prepare_write(file.fd, first.data(), static_cast<uint32_t>(first.size()), 0, 1));
+  REQUIRE(queue->prepare_write(file.fd, second.data(), static_cast<uint32_t>(second.size()), first.size(), 2));
+  REQUIRE(queue->pending() == 2);
+  for (const io_completion& completion : run(*queue, 2)) {
+    REQUIRE(!completion.result.has_error());
+    const size_t expected = completion.user_data == 1 ? first.size() : second.size();
+    REQUIRE(completion.result.get_value() == static_cast<int64_t>(expected));
+  }
+  REQUIRE(queue->pending() == 0);
+
+  // A full read, a short read at the end of the file, an empty read past it and a bad descriptor
+  char whole[64] {};
+  char tail[64] {};
+  char past[8] {};
+  char bad[8] {};
+  REQUIRE(queue->prepare_read(file.fd, whole, static_cast<uint32_t>(first.size()), 0, 10));
+  REQUIRE(queue->prepare_read(file.fd, tail, sizeof(tail), first.size(), 11));
+  REQUIRE(queue->prepare_read(file.fd, past, sizeof(past), 4096, 12));
+  REQUIRE(queue->prepare_read(-1, bad, sizeof(bad), 0, 13));
+  for (const io_completion& completion : run(*queue, 4)) {
+    switch (completion.user_data) {
+      case 10:
+        REQUIRE(completion.result.get_value() == static_cast<int64_t>(first.size()));
+        REQUIRE(std::string(whole) == first);
+        break;
+      case 11:
+        REQUIRE(completion.result.get_value() == static_cast<int64_t>(second.size()));
+        REQUIRE(std::string(tail) == second);
+        break;
+      case 12:
+        REQUIRE(completion.result.get_value() == 0);
+        break;
+      default:
+        REQUIRE(completion.user_data == 13);
+        REQUIRE(completion.result.has_error());
+        REQUIRE(completion.result.get_error() == std::errc::bad_file_descriptor);
+    }
+  }
+}
+
+TEST_CASE("io_uring_queue refuses SQEs beyond its capacity and wraps around")
+{
+  auto queue = try_queue(4);
+  if (!queue) {
+    return;
+  }
+  temp_file file("io_uring_wrap");
+  const char block[16] = "0123456789abcde";
+  REQUIRE(::pwrite(file.fd, block, sizeof(block), 0) == static_cast<ssize_t>(sizeof(block)));
+
+  // More rounds than ring entries, so both rings wrap
+  char buffers[4][4];
+  for (uint64_t round = 0; round < 5; ++round) {
+    for (uint64_t i = 0; i < 4; ++i) {
+      REQUIRE(queue->prepare_read(file.fd, buffers[i], 4, i * 4, round * 4 + i));
+    }
+    REQUIRE(!queue->prepare_read(file.fd, buffers[0], 4, 0, 99));
+    const auto completions = run(*queue, 4);
+    for (const io_completion& completion : completions) {
+      REQUIRE(completion.user_data / 4 == round);
+      REQUIRE(completion.result.get_value() == 4);
+      const uint64_t i = completion.user_data % 4;
+      REQUIRE(std::memcmp(buffers[i], block + i * 4, 4) == 0);
+    }
+  }
+}
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "expected64/memo_cache.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  negative_input,
+  misc_error
+};
+
+using result = expected64<int64_t, error_code>;
+
+result cube_non_negative(int64_t x)
+{
+  if (x < 0) {
+    return result(error_code::negative_input);
+  }
+  return result(x * x * x);
+}
+
+TEST_CASE("memo_cache lookups")
+{
+  memo_cache<int64_t, result> cache(1024);
+  REQUIRE(cache.capacity() >= 1024);
+
+  SECTION("Miss then hit")
+  {
+    REQUIRE(!cache.find(3).has_value());
+    cache.insert(3, cube_non_negative(3));
+    auto cached = cache.find(3);
+    REQUIRE(cached.has_value());
+    REQUIRE(cached->get_value() == 27);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.inserts == 1);
+  }
+
+  SECTION("Errors are cached")
+  {
+    int calls = 0;
+    auto counted = [&](int64_t x)
+    {
+      ++calls;
+      return cube_non_negative(x);
+    };
+    REQUIRE(cache.get_or_compute(-2, counted).get_error() == error_code::negative_input);
+    REQUIRE(cache.get_or_compute(-2, counted).get_error() == error_code::negative_input);
+    REQUIRE(calls == 1);
+  }
+
+  SECTION("Overwriting a key")
+  {
+    cache.insert(5, result(1));
+    cache.insert(5, result(2));
+    REQUIRE(cache.find(5)->get_value() == 2);
+  }
+
+  SECTION("A full set evicts")
+  {
+    memo_cache<int64_t, result, 2> tiny(2);  // One set, two ways
+    for (int64_t key = 0; key < 10; ++key) {
+      tiny.insert(key, cube_non_negative(key));
+    }
+    REQUIRE(tiny.stats().evictions == 8);
+    size_t present = 0;
+    for (int64_t key = 0; key < 10; ++key) {
+      if (auto cached = tiny.find(key)) {
+        REQUIRE(cached->get_value() == key * key * key);
+        ++present;
+      }
+    }
+    REQUIRE(present == 2);
+  }
+}
+
+TEST_CASE("memo_cache error TTL")
+{
+  memo_cache<int64_t, result> cache(64, std::chrono::milliseconds(1));
+  cache.insert(-1, cube_non_negative(-1));
+  cache.insert(4, cube_non_negative(4));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  REQUIRE(!cache.find(-1).has_value());  // Error expired
+  REQUIRE(cache.find(4)->get_value() == 64);  // Values never expire
+  REQUIRE(cache.stats().expired == 1);
+}
+
+TEST_CASE("memo_cache concurrent readers and writers")
+{
+  memo_cache<int64_t, result> cache(256);
+  std::atomic<int>            wrong {0};
+  std::vector<std::thread>    threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back(
+        [&, t]
+        {
+          for (int64_t i = 0; i < 20000; ++i) {
+            int64_t key = (i * 7 + t) % 1000 - 100;
+            if (cache.get_or_compute(key, cube_non_negative).to_bits() != cube_non_negative(key).to_bits()) {
+              wrong.fetch_add(1);
+            }
+          }
+        });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(wrong.load() == 0);
+  auto stats = cache.stats();
+  REQUIRE(stats.hits + stats.misses == 80000);
+}
@@ -0,0 +1,142 @@
+#include <optional>
+#include <type_traits>
+
+#include "expected64/optional64.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+static_assert(sizeof(optional64<int64_t>) == 8);
+static_assert(sizeof(optional64<uint64_t>) == 8);
+static_assert(sizeof(optional64<double>) == 8);
+static_assert(sizeof(optional64<int*>) == 8);
+static_assert(std::is_trivially_copyable_v<optional64<int64_t>>);
+static_assert(std::is_trivially_copyable_v<optional64<double>>);
+
+optional64<int64_t> parse_digit(char c)
+{
+  if (c < '0' || c > '9') {
+    return std::nullopt;
+  }
+  return c - '0';
+}
+
+TEST_CASE("optional64 basics")
+{
+  SECTION("Default constructed is empty")
+  {
+    optional64<int64_t> opt;
+    REQUIRE(!opt.has_value());
+    REQUIRE(!opt);
+    REQUIRE(opt == std::nullopt);
+  }
+
+  SECTION("Holding a value")
+  {
+    auto opt = parse_digit('7');
+    REQUIRE(opt.has_value());
+    REQUIRE(*opt == 7);
+    REQUIRE(opt.value() == 7);
+    REQUIRE(opt == 7);
+  }
+
+  SECTION("value() throws when empty")
+  {
+    auto opt = parse_digit('x');
+    REQUIRE_THROWS_AS(opt.value(), std::bad_optional_access);
+    REQUIRE(opt.value_or(-1) == -1);
+  }
+
+  SECTION("reset and emplace")
+  {
+    optional64<int64_t> opt = -42;
+    REQUIRE(opt.has_value());
+    opt.reset();
+    REQUIRE(!opt.has_value());
+    opt.emplace(0);
+    REQUIRE(opt == 0);
+    opt = std::nullopt;
+    REQUIRE(opt == std::nullopt);
+  }
+
+  SECTION("swap")
+  {
+    optional64<uint64_t> a = 5;
+    optional64<uint64_t> b;
+    swap(a, b);
+    REQUIRE(!a.has_value());
+    REQUIRE(b == 5);
+  }
+
+  SECTION("Equality")
+  {
+    REQUIRE(optional64<int64_t>() == optional64<int64_t>());
+    REQUIRE(optional64<int64_t>(1) == optional64<int64_t>(1));
+    REQUIRE(optional64<int64_t>(1) != optional64<int64_t>(2));
+    REQUIRE(optional64<int64_t>(1) != optional64<int64_t>());
+  }
+}
+
+TEST_CASE("optional64 niches")
+{
+  SECTION("double")
+  {
+    REQUIRE(!optional64<double>().has_value());
+    REQUIRE(optional64<double>(-0.5).value() < 0.0);
+    REQUIRE(optional64<double>(std::numeric_limits<double>::infinity()).has_value());
+    // NaN is the niche, so it cannot be held as a value
+    REQUIRE(!optional64<double>(std::numeric_limits<double>::quiet_NaN()).has_value());
+  }
+
+  SECTION("uint64_t")
+  {
+    REQUIRE(optional64<uint64_t>(std::numeric_limits<uint64_t>::max() >> 1).has_value());
+    REQUIRE(!optional64<uint64_t>(std::numeric_limits<uint64_t>::max()).has_value());
+  }
+
+  SECTION("int64_t")
+  {
+    REQUIRE(optional64<int64_t>(std::numeric_limits<int64_t>::max() >> 2).has_value());
+    REQUIRE(optional64<int64_t>(std::numeric_limits<int64_t>::min() / 4).has_value());
+    REQUIRE(!optional64<int64_t>(std::numeric_limits<int64_t>::max()).has_value());
+  }
+
+  SECTION("Pointers")
+  {
+    int value = 0;
+    REQUIRE(optional64<int*>(&value) == &value);
+    REQUIRE(optional64<int*>(nullptr).has_value());
+    REQUIRE(!optional64<int*>().has_value());
+  }
+}
+
+TEST_CASE("optional64 <-> expected64 conversions")
+{
+  SECTION("Value round trip")
+  {
+    auto opt = optional64<uint64_t>(expected64<uint64_t, error_code>(uint64_t {12345}));
+    REQUIRE(opt == 12345);
+    auto result = opt.to_expected(error_code::misc_error);
+    REQUIRE(!result.has_error());
+    REQUIRE(result.get_value() == 12345);
+  }
+
+  SECTION("Error becomes empty")
+  {
+    auto opt = optional64<double>(expected64<double, error_code>(error_code::calculation_error));
+    REQUIRE(!opt.has_value());
+  }
+
+  SECTION("Empty becomes the supplied error")
+  {
+    auto result = optional64<int64_t>().to_expected(error_code::misc_error);
+    REQUIRE(result.has_error());
+    REQUIRE(result.get_error() == error_code::misc_error);
+  }
+}
@@ -0,0 +1,188 @@
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "expected64/parallel.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  negative_input,
+  misc_error
+};
+
+using result = expected64<int64_t, error_code>;
+
+result square_non_negative(int64_t x)
+{
+  if (x < 0) {
+    return result(error_code::negative_input);
+  }
+  return result(x * x);
+}
+
+// Like square_non_negative, but -2 is a misc_error, so tests can tell which error was reported
+result square_or_classify(int64_t x)
+{
+  return x == -2 ? result(error_code::misc_error) : square_non_negative(x);
+}
+
+std::vector<int64_t> iota_inputs(size_t n)
+{
+  std::vector<int64_t> inputs(n);
+  std::iota(inputs.begin(), inputs.end(), 0);
+  return inputs;
+}
+
+TEST_CASE("work_stealing_executor")
+{
+  for (unsigned threads : {1U, 2U, 4U}) {
+    work_stealing_executor executor(threads);
+    REQUIRE(executor.concurrency() == threads);
+
+    SECTION("Every chunk runs exactly once, " + std::to_string(threads) + " threads")
+    {
+      std::vector<std::atomic<int>> hits(1000);
+      for (int round = 0; round < 3; ++round) {
+        executor.for_each_chunk(hits.size(),
+                                [&](size_t chunk)
+                                {
+                                  hits[chunk].fetch_add(1);
+                                  return true;
+                                });
+      }
+      for (auto& hit : hits) {
+        REQUIRE(hit.load() == 3);
+      }
+    }
+
+    SECTION("Returning false stops handing out chunks, " + std::to_string(threads) + " threads")
+    {
+      std::atomic<size_t> ran {0};
+      executor.for_each_chunk(100000,
+                              [&](size_t)
+                              {
+                                ran.fetch_add(1);
+                                return false;
+                              });
+      REQUIRE(ran.load() >= 1);
+      REQUIRE(ran.load() <= threads);
+    }
+
+    SECTION("An exception stops the loop and reaches the caller, " + std::to_string(threads) + " threads")
+    {
+      std::atomic<size_t> ran {0};
+      REQUIRE_THROWS_AS(executor.for_each_chunk(100000,
+                                                [&](size_t chunk)
+                                                {
+                                                  ran.fetch_add(1);
+                                                  if (chunk % 7 == 3) {
+                                                    throw std::runtime_error("chunk failed");
+                                                  }
+                                                  return true;
+                                                }),
+                        std::runtime_error);
+      REQUIRE(ran.load() < 100000);
+
+      // The executor is still usable afterwards
+      std::atomic<size_t> after {0};
+      executor.for_each_chunk(1000,
+                              [&](size_t)
+                              {
+                                after.fetch_add(1);
+                                return true;
+                              });
+      REQUIRE(after.load() == 1000);
+    }
+  }
+}
+
+TEST_CASE("parallel_transform")
+{
+  work_stealing_executor executor(4);
+  auto                   inputs = iota_inputs(100000);
+  std::vector<result>    outputs(inputs.size(), result(error_code::misc_error));
+
+  SECTION("All values")
+  {
+    auto status = parallel_transform(executor, inputs, outputs, square_non_negative, error_policy::run_all, 1000);
+    REQUIRE(!status.has_error());
+    REQUIRE(status.get_value() == inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      REQUIRE(outputs[i].get_value() == inputs[i] * inputs[i]);
+    }
+  }
+
+  SECTION("run_all reports the lowest-index error and still computes everything")
+  {
+    inputs[70000] = -1;
+    inputs[30000] = -2;
+    auto status = parallel_transform(executor, inputs, outputs, square_or_classify, error_policy::run_all, 1000);
+    REQUIRE(status.has_error());
+    REQUIRE(status.get_error() == error_code::misc_error);
+    REQUIRE(outputs[70000].has_error());
+    REQUIRE(outputs[30000].has_error());
+    REQUIRE(outputs.back().get_value() == inputs.back() * inputs.back());
+  }
+
+  SECTION("stop_on_first_error skips the remaining chunks")
+  {
+    inputs[0] = -1;
+    work_stealing_executor single(1);
+    auto                   policy = error_policy::stop_on_first_error;
+    auto                   status = parallel_transform(single, inputs, outputs, square_non_negative, policy, 1000);
+    REQUIRE(status.has_error());
+    REQUIRE(outputs[0].has_error());
+    REQUIRE(outputs.back().get_error() == error_code::misc_error);  // Never written
+  }
+}
+
+TEST_CASE("parallel_for_each")
+{
+  work_stealing_executor executor(3);
+  auto                   inputs = iota_inputs(50000);
+  std::atomic<int64_t>   sum {0};
+  auto                   status = parallel_for_each(
+      executor,
+      inputs,
+      [&](int64_t x)
+      {
+        sum.fetch_add(x, std::memory_order_relaxed);
+        return square_non_negative(x);
+      },
+      error_policy::run_all,
+      512);
+  REQUIRE(!status.has_error());
+  REQUIRE(sum.load() == std::accumulate(inputs.begin(), inputs.end(), int64_t {0}));
+
+  inputs[123] = -5;
+  status = parallel_for_each(executor, inputs, square_non_negative, error_policy::stop_on_first_error, 512);
+  REQUIRE(status.get_error() == error_code::negative_input);
+}
+
+TEST_CASE("parallel_reduce")
+{
+  work_stealing_executor executor(4);
+  auto                   inputs = iota_inputs(20000);
+  auto                   plus = [](int64_t a, int64_t b) { return a + b; };
+
+  auto total = parallel_reduce(executor, inputs, 7, square_non_negative, plus, error_policy::stop_on_first_error, 100);
+  REQUIRE(!total.has_error());
+  int64_t expected = 7;
+  for (int64_t x : inputs) {
+    expected += x * x;
+  }
+  REQUIRE(total.get_value() == expected);
+
+  inputs[19999] = -1;
+  inputs[5] = -1;
+  auto failed = parallel_reduce(executor, inputs, 0, square_non_negative, plus, error_policy::run_all, 100);
+  REQUIRE(failed.has_error());
+  REQUIRE(failed.get_error() == error_code::negative_input);
+
+  std::vector<int64_t> empty;
+  REQUIRE(parallel_reduce(executor, empty, 3, square_non_negative, plus).get_value() == 3);
+}
@@ -0,0 +1,167 @@
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>  // getpid
+
+#include "expected64/persistent_store.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+namespace
+{
+struct temp_path
+{
+  std::filesystem::path path;
+
+  explicit temp_path(const std::string& name)
+      : path(std::filesystem::temp_directory_path() / (name + "-" + std::to_string(::getpid()) + ".e64"))
+  {
+    std::filesystem::remove(path);
+  }
+
+  ~temp_path() { std::filesystem::remove(path); }
+};
+}  // namespace
+
+using result = expected64<double, error_code>;
+using store = persistent_store<int64_t, result>;
+
+TEST_CASE("persistent_store basics")
+{
+  temp_path file("basics");
+  store     table(file.path.string(), 100);
+  REQUIRE(table.capacity() == 128);
+  REQUIRE(table.size() == 0);
+  REQUIRE(!table.recovered());
+
+  REQUIRE(table.insert_or_assign(1, result(1.5)));
+  REQUIRE(table.insert_or_assign(-7, result(error_code::misc_error)));
+  REQUIRE(table.insert_or_assign(0, result(0.0)));  // Zero is a value, not an empty slot
+  REQUIRE(table.size() == 3);
+
+  REQUIRE(table.find(1)->get_value() > 1.4);
+  REQUIRE(table.find(-7)->get_error() == error_code::misc_error);
+  REQUIRE(!table.find(0)->has_error());
+  REQUIRE(!table.find(2).has_value());
+
+  REQUIRE(table.insert_or_assign(1, result(2.5)));
+  REQUIRE(table.find(1)->get_value() > 2.4);
+  REQUIRE(table.size() == 3);
+
+  REQUIRE(table.erase(1));
+  REQUIRE(!table.erase(1));
+  REQUIRE(!table.find(1).has_value());
+  REQUIRE(table.size() == 2);
+
+  REQUIRE(!table.insert_or_assign(5, result::reserved(0)));
+}
+
+TEST_CASE("persistent_store fills up")
+{
+  temp_path file("full");
+  store     table(file.path.string(), 16);
+  int64_t   inserted = 0;
+  while (table.insert_or_assign(inserted, result(static_cast<double>(inserted)))) {
+    ++inserted;
+  }
+  REQUIRE(inserted == 12);
+  for (int64_t key = 0; key < inserted; ++key) {
+    REQUIRE(table.find(key).has_value());
+  }
+}
+
+TEST_CASE("persistent_store reopening")
+{
+  temp_path file("reopen");
+
+  SECTION("After a clean close")
+  {
+    {
+      store table(file.path.string(), 1024);
+      for (int64_t key = 0; key < 500; ++key) {
+        const result value =
+            key % 10 == 0 ? result(error_code::calculation_error) : result(0.5 * static_cast<double>(key));
+        table.insert_or_assign(key, value);
+      }
+      table.erase(3);
+    }
+    store table(file.path.string(), 0);  // Capacity is ignored for an existing file
+    REQUIRE(!table.recovered());
+    REQUIRE(table.capacity() == 1024);
+    REQUIRE(table.size() == 499);
+    REQUIRE(table.find(20)->get_error() == error_code::calculation_error);
+    REQUIRE(table.find(21)->get_value() > 10.4);
+    REQUIRE(!table.find(3).has_value());
+  }
+
+  SECTION("After an unclean shutdown")
+  {
+    temp_path snapshot("snapshot");
+    {
+      store table(file.path.string(), 64);
+      table.insert_or_assign(42, result(4.2));
+      table.insert_or_assign(43, result(error_code::misc_error));
+      table.flush();
+      // Copying the file while it is open captures it as a crashed process would leave it
+      std::filesystem::copy_file(file.path, snapshot.path);
+    }
+    store table(snapshot.path.string(), 64);
+    REQUIRE(table.recovered());
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.find(42)->get_value() > 4.1);
+    REQUIRE(table.find(43)->get_error() == error_code::misc_error);
+  }
+
+  SECTION("A different layout is rejected")
+  {
+    {
+      store table(file.path.string(), 64);
+    }
+    REQUIRE_THROWS_AS((persistent_store<uint64_t, result>(file.path.string(), 64)), std::system_error);
+  }
+}
+
+TEST_CASE("persistent_store reclaims deleted slots")
+{
+  temp_path file("compact");
+  store     table(file.path.string(), 16);
+
+  // Churn: every insert is erased again, the table never holds more than one entry
+  for (int64_t key = 0; key < 1000; ++key) {
+    REQUIRE(table.insert_or_assign(key, result(static_cast<double>(key))));
+    REQUIRE(table.erase(key));
+  }
+  REQUIRE(table.size() == 0);
+
+  // Deleted slots in the middle of a probe sequence stay until compact()
+  int64_t inserted = 0;
+  while (table.insert_or_assign(inserted, result(static_cast<double>(inserted)))) {
+    ++inserted;
+  }
+  for (int64_t key = 0; key < inserted; key += 2) {
+    REQUIRE(table.erase(key));
+  }
+  table.insert_or_assign(1000, result(error_code::misc_error));
+  table.compact();
+  REQUIRE(!table.recovered());
+  REQUIRE(table.capacity() == 16);
+  for (int64_t key = 0; key < inserted; ++key) {
+    REQUIRE(table.find(key).has_value() == (key % 2 == 1));
+  }
+  REQUIRE(table.find(1000)->get_error() == error_code::misc_error);
+  const size_t live = table.size();
+  int64_t      added = 0;
+  while (table.insert_or_assign(2000 + added, result(0.0))) {
+    ++added;
+  }
+  REQUIRE(live + static_cast<size_t>(added) == 12);
+  REQUIRE(!std::filesystem::exists(file.path.string() + ".compact"));
+}
@@ -0,0 +1,200 @@
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "expected64/shm_ring.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+namespace
+{
+struct ring_name
+{
+  std::string name;
+
+  explicit ring_name(const std::string& suffix)
+      : name("/expected64-test-" + std::to_string(::getpid()) + "-" + suffix)
+  {
+    ::shm_unlink(name.c_str());
+  }
+
+  ~ring_name() { ::shm_unlink(name.c_str()); }
+};
+
+// Runs body in a child process and returns its exit status, or 128 + the signal that ended it
+template<typename F>
+int in_child(F body)
+{
+  const pid_t pid = ::fork();
+  if (pid == 0) {
+    ::_exit(body());
+  }
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+std::errc error_of(const std::function<void()>& attach)
+{
+  try {
+    attach();
+  } catch (const std::system_error& e) {
+    return static_cast<std::errc>(e.code().value());
+  }
+  return std::errc {};
+}
+}  // namespace
+
+using result = expected64<int64_t, error_code>;
+using writer = shm_ring_writer<result>;
+using reader = shm_ring_reader<result>;
+
+TEST_CASE("shm_ring delivers results in order")
+{
+  ring_name ring("order");
+  writer    out(ring.name, 10);
+  REQUIRE(out.capacity() == 16);
+  reader in(ring.name);
+  REQUIRE(in.capacity() == 16);
+  REQUIRE(!in.try_read().has_value());
+
+  out.publish(result(42));
+  out.publish(result(error_code::misc_error));
+  out.publish(result(-7));
+  REQUIRE(in.backlog() == 3);
+  REQUIRE(in.try_read()->get_value() == 42);
+  REQUIRE(in.try_read()->get_error() == error_code::misc_error);
+  REQUIRE(in.try_read()->get_value() == -7);
+  REQUIRE(!in.try_read().has_value());
+  REQUIRE(in.position() == 3);
+  REQUIRE(in.lost() == 0);
+
+  // A late reader starts at the head, and can seek back to messages still in the ring
+  reader late(ring.name);
+  REQUIRE(!late.try_read().has_value());
+  late.seek(1);
+  REQUIRE(late.try_read()->get_error() == error_code::misc_error);
+}
+
+TEST_CASE("shm_ring readers detect overruns")
+{
+  ring_name ring("overrun");
+  writer    out(ring.name, 8);
+  reader    in(ring.name);
+  for (int64_t i = 0; i < 20; ++i) {
+    out.publish(result(i));
+  }
+  // Messages 0-12 are gone, the oldest safe one is 13
+  auto first = in.try_read();
+  REQUIRE(first->get_value() == 13);
+  REQUIRE(in.lost() == 13);
+  for (int64_t i = 14; i < 20; ++i) {
+    REQUIRE(in.try_read()->get_value() == i);
+  }
+  REQUIRE(!in.try_read().has_value());
+  REQUIRE(in.lost() == 13);
+}
+
+TEST_CASE("shm_ring attach errors")
+{
+  ring_name ring("errors");
+  REQUIRE(error_of([&] { reader in(ring.name); }) == std::errc::no_such_file_or_directory);
+
+  writer out(ring.name, 8);
+  REQUIRE(error_of([&] { writer second(ring.name, 8); }) == std::errc::device_or_resource_busy);
+  REQUIRE(error_of([&] { shm_ring_reader<expected64<double, error_code>> in(ring.name); })
+          == std::errc::invalid_argument);
+  REQUIRE(error_of([&] { shm_ring_writer<expected64<int64_t, uint8_t>> other(ring.name, 8); })
+          == std::errc::invalid_argument);
+
+  ring_name                                     doubles("doubles");
+  shm_ring_writer<expected64<double, error_code>> double_out(doubles.name, 8);
+  REQUIRE(error_of([&] { shm_ring_reader<expected64<double, error_code, tagged_nan_policy>> in(doubles.name); })
+          == std::errc::invalid_argument);
+}
+
+TEST_CASE("shm_ring writers reattach after a detach or a crash")
+{
+  ring_name             ring("reattach");
+  std::optional<reader> in;
+  {
+    writer out(ring.name, 128);
+    in.emplace(ring.name);
+    out.publish(result(0));
+  }
+  {
+    writer out(ring.name, 8);  // Capacity of the existing ring
+    REQUIRE(out.capacity() == 128);
+    REQUIRE(out.position() == 1);
+    out.publish(result(1));
+  }
+
+  // A writer process killed without detaching
+  REQUIRE(in_child(
+              [&]
+              {
+                writer out(ring.name, 128);
+                for (int64_t i = 2; i < 100; ++i) {
+                  out.publish(result(i));
+                }
+                ::raise(SIGKILL);
+                return 0;
+              })
+          == 128 + SIGKILL);
+
+  writer out(ring.name, 128);
+  REQUIRE(out.position() == 100);
+  out.publish(result(100));
+  for (int64_t i = 0; i <= 100; ++i) {
+    REQUIRE(in->try_read()->get_value() == i);
+  }
+  REQUIRE(in->lost() == 0);
+}
+
+TEST_CASE("shm_ring across processes")
+{
+  ring_name     ring("processes");
+  const int64_t count = 200000;
+  writer        out(ring.name, 1024);
+
+  // Every message is its sequence number, or an error for multiples of 1000, so the reader can check each one
+  const pid_t pid = ::fork();
+  if (pid == 0) {
+    reader  in(ring.name);
+    int64_t received = 0;
+    in.seek(0);
+    while (in.position() < static_cast<uint64_t>(count)) {
+      if (auto message = in.try_read()) {
+        const auto sequence = static_cast<int64_t>(in.position() - 1);
+        const bool ok = sequence % 1000 == 0 ? message->get_error() == error_code::calculation_error
+                                             : !message->has_error() && message->get_value() == sequence;
+        if (!ok) {
+          ::_exit(1);
+        }
+        ++received;
+      }
+    }
+    ::_exit(received > 0 && received + static_cast<int64_t>(in.lost()) == count ? 0 : 2);
+  }
+
+  for (int64_t i = 0; i < count; ++i) {
+    out.publish(i % 1000 == 0 ? result(error_code::calculation_error) : result(i));
+  }
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  REQUIRE(WIFEXITED(status));
+  REQUIRE(WEXITSTATUS(status) == 0);
+}
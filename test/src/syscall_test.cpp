@@ -0,0 +1,120 @@
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "expected64/syscall.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+struct temp_file
+{
+  std::filesystem::path path;
+  int                   fd;
+
+  explicit temp_file(const std::string& name)
+      : path(std::filesystem::temp_directory_path() / (name + "-" + std::to_string(::getpid()) + ".sys"))
+      , fd(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))
+  {
+  }
+
+  ~temp_file()
+  {
+    ::close(fd);
+    std::filesystem::remove(path);
+  }
+};
+}  // namespace
+
+TEST_CASE("from_return keeps counts and encodes -errno like set_error")
+{
+  for (const long count : {0L, 1L, 4096L, (1L << 40)}) {
+    REQUIRE(!sys::from_return(count).has_error());
+    REQUIRE(sys::from_return(count).get_value() == count);
+  }
+  for (const int errno_value : {EPERM, EBADF, EINTR, EAGAIN, ESPIPE, 4095}) {
+    const sys::result result = sys::from_return(-errno_value);
+    REQUIRE(result.has_error());
+    REQUIRE(result.get_error() == static_cast<std::errc>(errno_value));
+    REQUIRE(result.to_bits() == sys::result(static_cast<std::errc>(errno_value)).to_bits());
+  }
+
+  int target = 0;
+  REQUIRE(sys::mapping(sys::from_return(reinterpret_cast<long>(&target))) == &target);
+}
+
+TEST_CASE("read, write, pread and lseek on a local file")
+{
+  temp_file file("syscall");
+  REQUIRE(file.fd >= 0);
+
+  const std::string text = "expected64 without errno\n";
+  const sys::result written = sys::write(file.fd, text.data(), text.size());
+  REQUIRE(written.get_value() == static_cast<int64_t>(text.size()));
+
+  REQUIRE(sys::lseek(file.fd, 0, SEEK_CUR).get_value() == static_cast<int64_t>(text.size()));
+  REQUIRE(sys::lseek(file.fd, 0, SEEK_SET).get_value() == 0);
+
+  char buffer[64] {};
+  REQUIRE(sys::read(file.fd, buffer, sizeof(buffer)).get_value() == static_cast<int64_t>(text.size()));
+  REQUIRE(std::string(buffer) == text);
+  REQUIRE(sys::read(file.fd, buffer, sizeof(buffer)).get_value() == 0);  // End of file
+
+  char word[8] {};
+  REQUIRE(sys::pread(file.fd, word, 7, 11).get_value() == 7);
+  REQUIRE(std::string(word) == "without");
+  REQUIRE(sys::lseek(file.fd, 0, SEEK_CUR).get_value() == static_cast<int64_t>(text.size()));  // pread doesn't move
+}
+
+TEST_CASE("Failed calls carry the errno libc would have set")
+{
+  char buffer[8];
+  REQUIRE(sys::read(-1, buffer, sizeof(buffer)).get_error() == std::errc::bad_file_descriptor);
+  REQUIRE(sys::write(-1, buffer, sizeof(buffer)).get_error() == std::errc::bad_file_descriptor);
+  REQUIRE(sys::pread(-1, buffer, sizeof(buffer), 0).get_error() == std::errc::bad_file_descriptor);
+
+  temp_file file("syscall_errors");
+  REQUIRE(sys::lseek(file.fd, 0, 12345).get_error() == std::errc::invalid_argument);
+  REQUIRE(sys::pread(file.fd, buffer, sizeof(buffer), -1).get_error() == std::errc::invalid_argument);
+
+  int pipe_fds[2];
+  REQUIRE(::pipe(pipe_fds) == 0);
+  REQUIRE(sys::lseek(pipe_fds[0], 0, SEEK_SET).get_error() == std::errc::invalid_seek);
+  errno = 0;
+  REQUIRE(::lseek(pipe_fds[0], 0, SEEK_SET) == -1);
+  REQUIRE(errno == ESPIPE);
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+
+  // The wrappers never touch errno
+  errno = 0;
+  REQUIRE(sys::read(-1, buffer, sizeof(buffer)).has_error());
+  REQUIRE(errno == 0);
+}
+
+TEST_CASE("mmap returns the mapping or the error")
+{
+  const size_t      length = 1 << 16;
+  const sys::result mapped = sys::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  REQUIRE(!mapped.has_error());
+  auto* bytes = static_cast<char*>(sys::mapping(mapped));
+  bytes[0] = 1;
+  bytes[length - 1] = 2;
+  REQUIRE(bytes[0] + bytes[length - 1] == 3);
+  REQUIRE(::munmap(bytes, length) == 0);
+
+  REQUIRE(sys::mmap(nullptr, 0, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0).get_error()
+          == std::errc::invalid_argument);
+
+  // Whatever the kernel reports for a shared mapping of no file, libc sees the same
+  errno = 0;
+  REQUIRE(::mmap(nullptr, length, PROT_READ, MAP_SHARED, -1, 0) == MAP_FAILED);
+  const int libc_errno = errno;
+  REQUIRE(sys::mmap(nullptr, length, PROT_READ, MAP_SHARED, -1, 0).get_error() == static_cast<std::errc>(libc_errno));
+}
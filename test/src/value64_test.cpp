@@ -0,0 +1,161 @@
+#include <limits>
+#include <string>
+
+#include "expected64/value64.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  type_error
+};
+
+using value = value64<error_code>;
+
+static_assert(sizeof(value) == 8);
+static_assert(std::is_trivially_copyable_v<value>);
+
+TEST_CASE("value64 boxing")
+{
+  SECTION("Default is null")
+  {
+    value v;
+    REQUIRE(v.is_null());
+    REQUIRE(v.type() == value::kind::null);
+  }
+
+  SECTION("Doubles are stored unchanged")
+  {
+    auto v = value::from_double(-2.5);
+    REQUIRE(v.is_double());
+    REQUIRE(v.is_number());
+    REQUIRE(!v.is_int());
+    REQUIRE(v.as_double() < -2.4);
+    REQUIRE(value::from_double(std::numeric_limits<double>::infinity()).is_double());
+  }
+
+  //   63                                                                  0
+  //  |---------------------------------------------------------------------|
+  //  | 1 | 11111111111 | 1 | 000 | 000000000000000000000000000000000000000 |
+  //  |---------------------------------------------------------------------|
+
+  SECTION("NaNs stay doubles")
+  {
+    auto negative_nan = std::bit_cast<double>(static_cast<uint64_t>(0xFFF8'0000'0000'0000));
+    REQUIRE(value::from_double(negative_nan).is_double());
+    auto payload_nan = std::bit_cast<double>(static_cast<uint64_t>(0xFFFD'0000'0000'0001));
+    REQUIRE(value::from_double(payload_nan).is_double());
+    REQUIRE(std::isnan(value::from_double(payload_nan).as_double()));
+  }
+
+  SECTION("48-bit ints")
+  {
+    constexpr int64_t largest = (static_cast<int64_t>(1) << 47) - 1;
+    constexpr int64_t smallest = -(static_cast<int64_t>(1) << 47);
+    REQUIRE(value::from_int(-7).as_int() == -7);
+    REQUIRE(value::from_int(largest).as_int() == largest);
+    REQUIRE(value::from_int(smallest).as_int() == smallest);
+    REQUIRE(value::from_int(largest + 1).is_double());
+  }
+
+  SECTION("Bools, pointers and errors")
+  {
+    std::string text = "hello";
+    REQUIRE(value::from_bool(true).as_bool());
+    REQUIRE(!value::from_bool(false).as_bool());
+    REQUIRE(value::from_pointer(&text).as_pointer<std::string*>() == &text);
+    auto err = value::from_error(error_code::calculation_error);
+    REQUIRE(err.has_error());
+    REQUIRE(err.get_error() == error_code::calculation_error);
+  }
+
+  SECTION("From expected64")
+  {
+    REQUIRE(value::from_expected(expected64<double, error_code>(1.5)).is_double());
+    REQUIRE(value::from_expected(expected64<int64_t, error_code>(3)).as_int() == 3);
+    auto err = value::from_expected(expected64<double, error_code>(error_code::calculation_error));
+    REQUIRE(err.get_error() == error_code::calculation_error);
+  }
+}
+
+TEST_CASE("value64 visit")
+{
+  auto name_of = [](value v)
+  {
+    return v.visit(
+        [](auto x) -> std::string
+        {
+          using X = decltype(x);
+          if constexpr (std::is_same_v<X, double>) {
+            return "double";
+          } else if constexpr (std::is_same_v<X, int64_t>) {
+            return "int";
+          } else if constexpr (std::is_same_v<X, bool>) {
+            return "bool";
+          } else if constexpr (std::is_same_v<X, std::nullptr_t>) {
+            return "null";
+          } else if constexpr (std::is_same_v<X, const void*>) {
+            return "pointer";
+          } else {
+            return "error";
+          }
+        });
+  };
+
+  int x = 0;
+  REQUIRE(name_of(value::from_double(1.0)) == "double");
+  REQUIRE(name_of(value::from_int(1)) == "int");
+  REQUIRE(name_of(value::from_bool(false)) == "bool");
+  REQUIRE(name_of(value::null()) == "null");
+  REQUIRE(name_of(value::from_pointer(&x)) == "pointer");
+  REQUIRE(name_of(value::from_error(error_code::type_error)) == "error");
+}
+
+TEST_CASE("value64 arithmetic")
+{
+  constexpr auto type_error = error_code::type_error;
+
+  SECTION("Int fast path")
+  {
+    auto r = add(value::from_int(40), value::from_int(2), type_error);
+    REQUIRE(r.is_int());
+    REQUIRE(r.as_int() == 42);
+    REQUIRE(sub(value::from_int(2), value::from_int(5), type_error).as_int() == -3);
+    REQUIRE(mul(value::from_int(-6), value::from_int(7), type_error).as_int() == -42);
+  }
+
+  SECTION("Int overflow widens to double")
+  {
+    constexpr int64_t largest = (static_cast<int64_t>(1) << 47) - 1;
+    auto              r = add(value::from_int(largest), value::from_int(1), type_error);
+    REQUIRE(r.is_double());
+    REQUIRE(r.as_double() > static_cast<double>(largest));
+  }
+
+  SECTION("Double and mixed")
+  {
+    REQUIRE(add(value::from_double(0.5), value::from_double(0.25), type_error).as_double() > 0.7);
+    auto mixed = mul(value::from_int(3), value::from_double(0.5), type_error);
+    REQUIRE(mixed.is_double());
+    REQUIRE(mixed.as_double() > 1.4);
+    REQUIRE(div(value::from_int(1), value::from_int(4), type_error).as_double() < 0.26);
+  }
+
+  SECTION("Errors propagate left to right")
+  {
+    auto lhs = value::from_error(error_code::calculation_error);
+    auto r = add(lhs, value::from_error(error_code::type_error), type_error);
+    REQUIRE(r.get_error() == error_code::calculation_error);
+    REQUIRE(add(value::from_int(1), lhs, type_error).get_error() == error_code::calculation_error);
+  }
+
+  SECTION("Non-numbers are a type error")
+  {
+    auto r = add(value::from_int(1), value::from_bool(true), type_error);
+    REQUIRE(r.has_error());
+    REQUIRE(r.get_error() == type_error);
+    REQUIRE(sub(value::null(), value::from_double(1.0), type_error).get_error() == type_error);
+  }
+}
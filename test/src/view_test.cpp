@@ -0,0 +1,121 @@
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+#include "expected64/parallel.hpp"
+#include "expected64/view.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  calculation_error,
+  misc_error
+};
+
+static_assert(std::ranges::contiguous_range<expected64_view<double, error_code>>);
+
+TEST_CASE("expected64_view reads doubles in place")
+{
+  const std::vector<double> prices = {101.25, -0.5, 0.0, 1e300, -std::numeric_limits<double>::infinity()};
+  const expected64_view<double, error_code> view(prices);
+  REQUIRE(view.size() == prices.size());
+  REQUIRE(view.words() == reinterpret_cast<const uint64_t*>(prices.data()));
+  REQUIRE(static_cast<const void*>(view.data()) == static_cast<const void*>(prices.data()));
+  for (size_t i = 0; i < prices.size(); ++i) {
+    REQUIRE(!view[i].has_error());
+    REQUIRE(view[i].to_bits() == expected64<double, error_code>(prices[i]).to_bits());
+  }
+  REQUIRE(view.is_valid());
+  REQUIRE(view.collisions().empty());
+
+  size_t count = 0;
+  for (const auto& result : view) {
+    count += !result.has_error();
+  }
+  REQUIRE(count == prices.size());
+}
+
+TEST_CASE("expected64_view reports collisions with the error encoding")
+{
+  std::vector<double> values(1000, 1.5);
+  values[3] = std::numeric_limits<double>::quiet_NaN();
+  values[64] = -std::numeric_limits<double>::quiet_NaN();
+  values[999] = std::numeric_limits<double>::signaling_NaN();
+  const expected64_view<double, error_code> view(values);
+  REQUIRE(!view.is_valid());
+  REQUIRE(view.collisions() == std::vector<size_t> {3, 64, 999});
+
+  std::vector<uint64_t> bits((values.size() + 63) / 64);
+  REQUIRE(view.validate(bits.data()) == 3);
+  REQUIRE(bits[0] == 1ULL << 3);
+  REQUIRE(bits[1] == 1);
+  REQUIRE(bits[15] == 1ULL << (999 % 64));
+  REQUIRE(view[3].has_error());
+
+  // Beyond the first validation block
+  std::vector<double> large(10000, 2.0);
+  REQUIRE(expected64_view<double, error_code>(large).is_valid());
+  large[9000] = std::numeric_limits<double>::quiet_NaN();
+  REQUIRE(!expected64_view<double, error_code>(large).is_valid());
+  REQUIRE(expected64_view<double, error_code>(large).collisions() == std::vector<size_t> {9000});
+}
+
+TEST_CASE("expected64_view with tagged_nan_policy accepts missing values")
+{
+  using view_type = expected64_view<double, error_code, tagged_nan_policy>;
+  const double        nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> values(1000, 1.5);
+  values[3] = nan;
+  values[64] = -nan;
+  values[999] = std::numeric_limits<double>::signaling_NaN();
+  REQUIRE(view_type(values).is_valid());
+  REQUIRE(view_type(values).collisions().empty());
+  REQUIRE(std::isnan(view_type(values)[3].get_value()));
+
+  values[500] = std::bit_cast<double>(tagged_nan_policy::error_tag | 7);
+  REQUIRE(view_type(values).collisions() == std::vector<size_t> {500});
+}
+
+TEST_CASE("expected64_view over integers")
+{
+  const int64_t              limit = INT64_C(1) << 62;
+  const std::vector<int64_t> ints = {0, -1, limit - 1, -limit, limit, -limit - 1, INT64_MAX, INT64_MIN, 42};
+
+  const expected64_view<int64_t, error_code> view(ints);
+  REQUIRE(view.collisions() == std::vector<size_t> {4, 5, 6, 7});
+  REQUIRE(view[2].get_value() == limit - 1);
+  REQUIRE(view[3].get_value() == -limit);
+  REQUIRE(view[8].get_value() == 42);
+
+  const std::vector<uint64_t> unsigned_ints = {0, UINT64_MAX >> 1, 1ULL << 63, 7};
+  const expected64_view<uint64_t, error_code> unsigned_view(unsigned_ints);
+  REQUIRE(unsigned_view.collisions() == std::vector<size_t> {2});
+  REQUIRE(unsigned_view[1].get_value() == UINT64_MAX >> 1);
+
+  const expected64_view<int64_t, error_code> empty(std::span<const int64_t> {});
+  REQUIRE(empty.empty());
+  REQUIRE(empty.is_valid());
+  REQUIRE(empty.collisions().empty());
+}
+
+TEST_CASE("expected64_view with the result tooling")
+{
+  std::vector<int64_t> numbers(5000);
+  for (size_t i = 0; i < numbers.size(); ++i) {
+    numbers[i] = static_cast<int64_t>(i);
+  }
+  using result = expected64<int64_t, error_code>;
+  const expected64_view<int64_t, error_code> view(numbers);
+  REQUIRE(batch_sum<result>(view.words(), view.size()).get_value() == 4999 * 5000 / 2);
+
+  work_stealing_executor executor(2);
+  REQUIRE(parallel_first_error(executor, view) == view.size());
+  numbers[4321] = INT64_MAX;  // Collides, and reads as an error
+  REQUIRE(parallel_first_error(executor, view) == 4321);
+  REQUIRE(batch_sum<result>(view.words(), view.size()).has_error());
+}
@@ -0,0 +1,86 @@
+#include <vector>
+
+#include "expected64/parallel.hpp"
+#include "expected64/when_all.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+enum class error_code
+{
+  no_error = 0,
+  bad_bid,
+  bad_ask,
+  bad_vol
+};
+
+TEST_CASE("expected64::error_msb")
+{
+  using int_result = expected64<int64_t, error_code>;
+  using double_result = expected64<double, error_code>;
+
+  REQUIRE(int_result::error_msb(int_result(-5).to_bits()) == 0);
+  REQUIRE(int_result::error_msb(int_result(error_code::bad_bid).to_bits()) != 0);
+  REQUIRE(double_result::error_msb(double_result(std::numeric_limits<double>::infinity()).to_bits()) == 0);
+  REQUIRE(double_result::error_msb(double_result(-std::numeric_limits<double>::infinity()).to_bits()) == 0);
+  REQUIRE(double_result::error_msb(double_result(error_code::bad_vol).to_bits()) != 0);
+  REQUIRE(double_result::error_msb(double_result(-std::numeric_limits<double>::quiet_NaN()).to_bits()) != 0);
+
+  auto round_trip = int_result::from_bits(int_result(error_code::bad_ask).to_bits());
+  REQUIRE(round_trip.get_error() == error_code::bad_ask);
+}
+
+TEST_CASE("when_all")
+{
+  using price = expected64<double, error_code>;
+  using size = expected64<uint64_t, error_code>;
+  int   instrument = 0;
+
+  SECTION("All valid")
+  {
+    auto quote = when_all(price(99.5), price(100.5), size(uint64_t {300}), expected64<int*, error_code>(&instrument));
+    REQUIRE(!quote.has_error());
+    REQUIRE(quote.get_value<1>() > 100.0);
+    REQUIRE(quote.get_value<2>() == 300);
+    auto [bid, ask, qty, ptr] = quote.get_values();
+    REQUIRE(bid < ask);
+    REQUIRE(qty == 300);
+    REQUIRE(ptr == &instrument);
+  }
+
+  SECTION("Leftmost error wins")
+  {
+    auto quote = when_all(price(99.5), price(error_code::bad_ask), price(error_code::bad_vol));
+    REQUIRE(quote.has_error());
+    REQUIRE(quote.get_error() == error_code::bad_ask);
+  }
+
+  SECTION("Single encoding family")
+  {
+    auto ok = when_all(size(uint64_t {1}), size(uint64_t {2}), size(uint64_t {3}));
+    REQUIRE(!ok.has_error());
+    auto failed = when_all(size(uint64_t {1}), size(uint64_t {2}), size(error_code::bad_bid));
+    REQUIRE(failed.has_error());
+    REQUIRE(failed.get_error() == error_code::bad_bid);
+    REQUIRE(failed.get<0>().get_value() == 1);
+  }
+}
+
+TEST_CASE("parallel_first_error")
+{
+  using result = expected64<int64_t, error_code>;
+  work_stealing_executor executor(4);
+  std::vector<result>    results(100000, result(1));
+
+  REQUIRE(parallel_first_error(executor, results, 1000) == results.size());
+  REQUIRE(parallel_when_all(executor, results, 1000).get_value() == results.size());
+
+  results[77777] = result(error_code::bad_vol);
+  results[4321] = result(error_code::bad_bid);
+  results[4322] = result(error_code::bad_ask);
+  for (int round = 0; round < 20; ++round) {
+    REQUIRE(parallel_first_error(executor, results, 1000) == 4321);
+  }
+  auto combined = parallel_when_all(executor, results, 1000);
+  REQUIRE(combined.has_error());
+  REQUIRE(combined.get_error() == error_code::bad_bid);
+}